@@ -47,6 +47,7 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time, In
     arg = param;
     when = time;
     type = kind;
+    link.item = this;
 }
 
 //----------------------------------------------------------------------
@@ -59,7 +60,7 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time, In
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    pending = new LinkList();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -152,30 +153,50 @@ Interrupt::OneTick()
     DEBUG('t',"Entering OneTick\n");
     MachineStatus old = status;
 
-// advance simulated time
-    if (status == SystemMode) {
-        stats->totalTicks += SystemTick;
-	stats->systemTicks += SystemTick;
-    currentThread->addTime();
-    } else {					// USER_PROGRAM
-	stats->totalTicks += UserTick;
-	stats->userTicks += UserTick;
-    }
-    DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
+// advance simulated time, once every CPU has had its turn
+    if (cpuSet->EndOfRound()) {
+	if (status == SystemMode) {
+	    stats->totalTicks += SystemTick;
+	    stats->systemTicks += SystemTick;
+	    cpuSet->Tick(SystemTick, TRUE);
+	} else {				// USER_PROGRAM
+	    stats->totalTicks += UserTick;
+	    stats->userTicks += UserTick;
+	    cpuSet->Tick(UserTick, FALSE);
+	}
+	DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
 
 // check any pending interrupts are now ready to fire
-    ChangeLevel(IntOn, IntOff);		// first, turn off interrupts
+	ChangeLevel(IntOn, IntOff);	// first, turn off interrupts
 					// (interrupt handlers run with
 					// interrupts disabled)
-    while (CheckIfDue(FALSE))		// check for pending interrupts
-	;
-    ChangeLevel(IntOff, IntOn);		// re-enable interrupts
+	while (CheckIfDue(FALSE))	// check for pending interrupts
+	    ;
+	ChangeLevel(IntOff, IntOn);	// re-enable interrupts
+    }
     if (yieldOnReturn) {		// if the timer device handler asked 
 					// for a context switch, ok to do it now
 	yieldOnReturn = FALSE;
  	status = SystemMode;		// yield is a kernel routine
-	currentThread->Yield();
-	status = old;
+	currentThread->Preempt();
+	ChangeLevel(level, IntOn);	// we were switched out with 
+	status = old;			// interrupts on, but whoever 
+    }					// switched back may have had them off
+
+// let the next CPU have its turn
+    if (cpuSet->NumCpus() > 1) {
+	ChangeLevel(IntOn, IntOff);
+	cpuSet->NextTurn();
+	ChangeLevel(IntOff, IntOn);
+	status = old;			// the CPU we came back from may 
+					// have been in another mode
+	if (currentCpu->needResched) {	// our time slice ran out while
+	    currentCpu->needResched = FALSE;	// another CPU had its turn
+	    status = SystemMode;
+	    currentThread->Preempt();
+	    ChangeLevel(level, IntOn);
+	    status = old;
+	}
     }
     DEBUG('t',"leaving OneTick\n");
 }
@@ -198,6 +219,39 @@ Interrupt::YieldOnReturn()
     yieldOnReturn = TRUE; 
 }
 
+//----------------------------------------------------------------------
+// Interrupt::YieldOnNextTick
+// 	Called from kernel code (not an interrupt handler), with 
+//	interrupts disabled, to cause a context switch in the running 
+//	thread as soon as it is safe -- the next time interrupts are 
+//	re-enabled and simulated time advances.  The scheduler uses this 
+//	to preempt the running thread when a more important one wakes up.
+//
+//	Interrupt handlers must use YieldOnReturn instead.
+//----------------------------------------------------------------------
+
+void
+Interrupt::YieldOnNextTick()
+{ 
+    ASSERT(inHandler == FALSE);  
+    yieldOnReturn = TRUE; 
+}
+
+//----------------------------------------------------------------------
+// Interrupt::CancelYield
+// 	Called by the scheduler when it switches out the running thread.
+//	A context switch asked for with YieldOnReturn or YieldOnNextTick 
+//	was meant for that thread; if it blocked before the switch could
+//	happen, the request must not be left over to preempt whichever 
+//	thread runs next.
+//----------------------------------------------------------------------
+
+void
+Interrupt::CancelYield()
+{
+    yieldOnReturn = FALSE;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::Idle
 // 	Routine called when there is nothing in the ready queue.
@@ -244,6 +298,9 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+    cpuSet->Print();
+    tcbPool->Print();
+    stackPool->Print();
     Cleanup();     // Never returns.
 }
 
@@ -273,7 +330,7 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending->SortedInsert(&toOccur->link, when);
 }
 
 //----------------------------------------------------------------------
@@ -309,14 +366,15 @@ Interrupt::CheckIfDue(bool advanceClock)
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
     } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
+	pending->SortedInsert(&toOccur->link, when);
 	return FALSE;
     }
 
-// Check if there is nothing more to do, and if so, quit
+// Check if there is nothing more to do, and if so, quit -- unless
+// some thread is asleep, waiting for the timer to wake it up
     if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+		&& pending->IsEmpty() && alarmClock->IsEmpty()) {
+	 pending->SortedInsert(&toOccur->link, when);
 	 return FALSE;
     }
 
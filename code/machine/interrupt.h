@@ -67,6 +67,7 @@ class PendingInterrupt {
     int arg;                    // The argument to the function.
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+    ListLink link;		// links it into the pending list
 };
 
 // The following class defines the data structures for the simulation
@@ -94,6 +95,11 @@ class Interrupt {
     
     void YieldOnReturn();		// cause a context switch on return 
 					// from an interrupt handler
+    void YieldOnNextTick();		// cause a context switch the next
+					// time simulated time advances
+    void CancelYield();			// the thread a context switch was
+					// asked for has been switched out
+    bool InHandler() { return inHandler; } // are we in a handler?
 
     MachineStatus getStatus() { return status; } // idle, kernel, user
     void setStatus(MachineStatus st) { status = st; }
@@ -114,7 +120,7 @@ class Interrupt {
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
+    LinkList *pending;		// the list of interrupts scheduled
 				// to occur in the future
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
@@ -22,6 +22,10 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numSteals = numResumes = numLocalResumes = 0;
+    numContextSwitches = numSlicesUsedUp = 0;
+    numLockAcquires = numLockWaits = 0;
+    numUserRestores = numRegisterLoads = numSpaceLoads = 0;
 }
 
 //----------------------------------------------------------------------
@@ -41,4 +45,16 @@ Statistics::Print()
     printf("Paging: faults %d\n", numPageFaults);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
+    printf("Scheduling: steals %d, resumes %d, on the same CPU %d (%.1f%%)\n",
+	numSteals, numResumes, numLocalResumes, 
+	(numResumes == 0) ? 100.0 : 100.0 * numLocalResumes / numResumes);
+    printf("Context switches: %d, time slices used up %d\n", 
+	numContextSwitches, numSlicesUsedUp);
+    printf("Locks: acquired %d times, had to wait %d times\n",
+	numLockAcquires, numLockWaits);
+#ifdef USER_PROGRAM
+    printf("User context: restores %d, register loads %d, "
+	"address space loads %d\n", numUserRestores, numRegisterLoads,
+	numSpaceLoads);
+#endif
 }
@@ -35,6 +35,21 @@ class Statistics {
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numSteals;		// number of threads one CPU took from another
+    int numResumes;		// number of times a thread that has run 
+				// before was given a CPU
+    int numLocalResumes;	// ... and it was the same CPU as last time
+    int numContextSwitches;	// number of times one thread was switched
+				// for another on a CPU
+    int numSlicesUsedUp;	// ... of which, how many because a time 
+				// slice was up
+    int numLockAcquires;	// number of times a Lock was acquired
+    int numLockWaits;		// ... of which, how many had to wait
+    int numUserRestores;	// number of times a user thread was 
+				// switched back in
+    int numRegisterLoads;	// ... and its registers had to be loaded
+    int numSpaceLoads;		// number of times the address space in 
+				// the machine was changed
 
     Statistics(); 		// initialize everything to zero
 
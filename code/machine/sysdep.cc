@@ -403,6 +403,47 @@ CallOnUserAbort(VoidNoArgFunctionPtr func)
     (void)signal(SIGINT, (VoidFunctionPtr) func);
 }
 
+//----------------------------------------------------------------------
+// CallOnSegFault
+// 	Arrange that "func" will be called, with the faulting address as 
+//	its argument, when Nachos makes an illegal memory reference (for
+//	instance, by running off the end of a thread's stack into its 
+//	guard page).  Nachos aborts once "func" returns.
+//
+//	The handler runs on a stack of its own, since the one that 
+//	faulted may have no room left.
+//----------------------------------------------------------------------
+
+static VoidFunctionPtr segFaultFunc;
+static char segFaultStack[64 * 1024];	// SIGSTKSZ is not a constant
+					// on every host
+
+static void
+HandleSegFault(int sig, siginfo_t *info, void *context)
+{
+    (*segFaultFunc)((int) info->si_addr);
+    Abort();
+}
+
+void 
+CallOnSegFault(VoidFunctionPtr func)
+{
+    stack_t ss;
+    struct sigaction act;
+
+    segFaultFunc = func;
+    ss.ss_sp = segFaultStack;
+    ss.ss_size = sizeof(segFaultStack);
+    ss.ss_flags = 0;
+    (void) sigaltstack(&ss, NULL);
+
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = HandleSegFault;
+    act.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&act.sa_mask);
+    (void) sigaction(SIGSEGV, &act, NULL);
+}
+
 //----------------------------------------------------------------------
 // Sleep
 // 	Put the UNIX process running Nachos to sleep for x seconds,
@@ -470,6 +511,12 @@ Random()
 //
 //	Note: Just return the useful part!
 //
+//	The array is mapped directly from the host, so that it starts on
+//	a page boundary and the boundary pages can really be protected; 
+//	its size is rounded up to a whole number of pages, so that the 
+//	end of the array butts against the page after it.  Pages of the 
+//	array that are never touched don't take up any memory.
+//
 //	"size" -- amount of useful space needed (in bytes)
 //----------------------------------------------------------------------
 
@@ -477,16 +524,20 @@ char *
 AllocBoundedArray(int size)
 {
     int pgSize = getpagesize();
-    char *ptr = new char[pgSize * 2 + size];
-
-    //mprotect(ptr, pgSize, 0);
-    //mprotect(ptr + pgSize + size, pgSize, 0);
+    int len = divRoundUp(size, pgSize) * pgSize;
+    char *ptr = (char *) mmap(NULL, pgSize * 2 + len, 
+			      PROT_READ | PROT_WRITE | PROT_EXEC,
+			      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    ASSERT(ptr != (char *) MAP_FAILED);
+    mprotect(ptr, pgSize, PROT_NONE);
+    mprotect(ptr + pgSize + len, pgSize, PROT_NONE);
     return ptr + pgSize;
 }
 
 //----------------------------------------------------------------------
 // DeallocBoundedArray
-// 	Deallocate an array of integers, unprotecting its two boundary pages.
+// 	Deallocate an array, along with its two boundary pages.
 //
 //	"ptr" -- the array to be deallocated
 //	"size" -- amount of useful space in the array (in bytes)
@@ -496,8 +547,27 @@ void
 DeallocBoundedArray(char *ptr, int size)
 {
     int pgSize = getpagesize();
+    int len = divRoundUp(size, pgSize) * pgSize;
+
+    munmap(ptr - pgSize, pgSize * 2 + len);
+}
+
+//----------------------------------------------------------------------
+// InBoundedArrayGuard
+// 	Return TRUE if "addr" lies in one of the two boundary pages of
+//	an array allocated by AllocBoundedArray.
+//
+//	"ptr" -- the array
+//	"size" -- amount of useful space in the array (in bytes)
+//	"addr" -- the address to check, typically a faulting address
+//----------------------------------------------------------------------
+
+bool
+InBoundedArrayGuard(char *ptr, int size, char *addr)
+{
+    int pgSize = getpagesize();
+    int len = divRoundUp(size, pgSize) * pgSize;
 
-    mprotect(ptr - pgSize, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    delete [] (ptr - pgSize);
+    return (addr >= ptr - pgSize && addr < ptr) 
+	|| (addr >= ptr + len && addr < ptr + len + pgSize);
 }
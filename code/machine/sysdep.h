@@ -46,6 +46,10 @@ extern void Delay(int seconds);
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(VoidNoArgFunctionPtr cleanUp);
 
+// Initialize system so that "func" is called with the faulting address
+// on an illegal memory reference, before Nachos aborts
+extern void CallOnSegFault(VoidFunctionPtr func);
+
 // Initialize the pseudo random number generator
 extern void RandomInit(unsigned seed);
 extern int Random();
@@ -54,6 +58,7 @@ extern int Random();
 // just beyond either end of the array will cause an error
 extern char *AllocBoundedArray(int size);
 extern void DeallocBoundedArray(char *p, int size);
+extern bool InBoundedArrayGuard(char *p, int size, char *addr);
 
 // Other C library routines that are used by Nachos.
 // These are assumed to be portable, so we don't include a wrapper.
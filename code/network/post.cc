@@ -45,13 +45,13 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
 //      Initialize a single mail box within the post office, so that it
 //	can receive incoming messages.
 //
-//	Just initialize a list of messages, representing the mailbox.
+//	Just initialize a queue of messages, representing the mailbox.
 //----------------------------------------------------------------------
 
 
 MailBox::MailBox()
 { 
-    messages = new SynchList(); 
+    messages = new RingQueue("mailbox", MailBoxSize); 
 }
 
 //----------------------------------------------------------------------
@@ -89,7 +89,11 @@ PrintHeader(PacketHeader pktHdr, MailHeader mailHdr)
 //	arrival, wake them up!
 //
 //	We need to reconstruct the Mail message (by concatenating the headers
-//	to the data), to simplify queueing the message on the SynchList.
+//	to the data), to simplify queueing the message on the RingQueue.
+//
+//	If the mailbox is full, the message is dropped, just as if the 
+//	network had lost it; waiting for room would hold up the delivery
+//	of mail to every other mailbox.
 //
 //	"pktHdr" -- source, destination machine ID's
 //	"mailHdr" -- source, destination mailbox ID's
@@ -101,9 +105,10 @@ MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
 { 
     Mail *mail = new Mail(pktHdr, mailHdr, data); 
 
-    messages->Append((void *)mail);	// put on the end of the list of 
-					// arrived messages, and wake up 
-					// any waiters
+    if (!messages->TryAppend((void *)mail)) {	// put on the end of the 
+	DEBUG('n', "Mailbox %d full, message dropped\n", mailHdr.to);
+	delete mail;				// queue of arrived messages,
+    }						// and wake up any waiters
 }
 
 //----------------------------------------------------------------------
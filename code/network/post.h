@@ -29,7 +29,8 @@
 #define POST_H
 
 #include "network.h"
-#include "synchlist.h"
+#include "synch.h"
+#include "ringqueue.h"
 
 // Mailbox address -- uniquely identifies a mailbox on a given machine.
 // A mailbox is just a place for temporary storage for messages.
@@ -74,6 +75,11 @@ class Mail {
 // for messages.   Incoming messages are put by the PostOffice into the 
 // appropriate mailbox, and these messages can then be retrieved by
 // threads on this machine.
+//
+// A mailbox holds at most MailBoxSize messages; like the network, it
+// drops any more that arrive before they are read.
+
+#define MailBoxSize	64	// must be a power of two
 
 class MailBox {
   public: 
@@ -87,7 +93,7 @@ class MailBox {
 				// mailbox (and wait if there is no message 
 				// to get!)
   private:
-    SynchList *messages;	// A mailbox is just a list of arrived messages
+    RingQueue *messages;	// A mailbox is just a queue of arrived messages
 };
 
 // The following class defines a "Post Office", or a collection of 
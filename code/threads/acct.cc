@@ -0,0 +1,278 @@
+// acct.cc
+//	Routines to keep per-thread CPU accounting, and to report on it
+//	when Nachos halts.
+//
+//	NOTE: the ThreadAcct routines are called with interrupts disabled
+//	(from the scheduler and the synchronization routines), or from
+//	the clock, so they need no mutual exclusion of their own.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "acct.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// ThreadAcct::ThreadAcct
+// 	Initialize a thread's accounting: it hasn't done anything yet.
+//----------------------------------------------------------------------
+
+ThreadAcct::ThreadAcct()
+{
+    userTicks = systemTicks = 0;
+    voluntary = involuntary = 0;
+    readyTicks = blockedTicks = 0;
+    waitList = NULL;
+    preempted = FALSE;
+    readySince = -1;
+    blockedOn = NULL;
+    blockedSince = 0;
+}
+
+//----------------------------------------------------------------------
+// ThreadAcct::~ThreadAcct
+// 	De-allocate the records of what the thread was blocked on.
+//----------------------------------------------------------------------
+
+ThreadAcct::~ThreadAcct()
+{
+    while (waitList != NULL) {
+	WaitRecord *rec = waitList;
+
+	waitList = rec->next;
+	delete rec;
+    }
+}
+
+//----------------------------------------------------------------------
+// ThreadAcct::Tick
+// 	Charge the thread for running while simulated time advanced.
+//
+//	"ticks" is how much time has passed.
+//	"system" is TRUE if the machine was in kernel mode.
+//----------------------------------------------------------------------
+
+void
+ThreadAcct::Tick(int ticks, bool system)
+{
+    if (system)
+	systemTicks += ticks;
+    else
+	userTicks += ticks;
+}
+
+//----------------------------------------------------------------------
+// ThreadAcct::Switched
+// 	Count a context switch away from the thread.
+//
+//	"forced" is TRUE if the thread was still willing to run.
+//----------------------------------------------------------------------
+
+void
+ThreadAcct::Switched(bool forced)
+{
+    if (forced)
+	involuntary++;
+    else
+	voluntary++;
+}
+
+//----------------------------------------------------------------------
+// ThreadAcct::Ready, ThreadAcct::Running
+// 	Keep track of how long the thread waits on a ready queue, from
+//	when it is put there until it starts to run.
+//----------------------------------------------------------------------
+
+void
+ThreadAcct::Ready()
+{
+    readySince = stats->totalTicks;
+}
+
+void
+ThreadAcct::Running()
+{
+    if (readySince >= 0)
+	readyTicks += stats->totalTicks - readySince;
+    readySince = -1;
+}
+
+//----------------------------------------------------------------------
+// ThreadAcct::Blocking, ThreadAcct::Woken
+// 	Keep track of how long the thread is blocked on a semaphore or
+//	condition variable, from when it goes to sleep until it is made
+//	ready again.  The time is added to the record for the object's
+//	name, so that all the semaphores called "buffer", say, count as
+//	one; the record is made the first time the thread blocks there.
+//
+//	"on" is the name of the object the thread is about to block on.
+//----------------------------------------------------------------------
+
+void
+ThreadAcct::Blocking(char *on)
+{
+    blockedOn = on;
+    blockedSince = stats->totalTicks;
+}
+
+void
+ThreadAcct::Woken()
+{
+    WaitRecord *rec, *last = NULL;
+    int ticks;
+
+    if (blockedOn == NULL)
+	return;
+    for (rec = waitList; rec != NULL; last = rec, rec = rec->next)
+	if (rec->name == blockedOn || !strcmp(rec->name, blockedOn))
+	    break;
+    if (rec == NULL) {
+	rec = new WaitRecord(blockedOn);
+	if (last == NULL)
+	    waitList = rec;
+	else
+	    last->next = rec;
+    }
+    ticks = stats->totalTicks - blockedSince;
+    rec->ticks += ticks;
+    rec->waits++;
+    blockedTicks += ticks;
+    blockedOn = NULL;
+}
+
+// The accounting of a thread that has finished.
+
+class AcctRecord {
+  public:
+    AcctRecord(Thread *thread);
+
+    char *name;
+    int tid;
+    ThreadAcct acct;
+};
+
+//----------------------------------------------------------------------
+// AcctRecord::AcctRecord
+// 	Copy the accounting of a thread that is about to be deleted.  The
+//	wait records are handed over, rather than copied.
+//----------------------------------------------------------------------
+
+AcctRecord::AcctRecord(Thread *thread)
+{
+    name = thread->getName();
+    tid = thread->getTid();
+    acct = thread->acct;
+    thread->acct.waitList = NULL;
+}
+
+//----------------------------------------------------------------------
+// AcctLog::AcctLog
+// 	Initialize the accounting log, with no finished threads.
+//
+//	"csvName" is the name of a UNIX file to write the report to, in
+//		comma separated form, or NULL for no such file.
+//----------------------------------------------------------------------
+
+AcctLog::AcctLog(char *csvName)
+{
+    finished = new List;
+    csvFile = csvName;
+}
+
+//----------------------------------------------------------------------
+// AcctLog::~AcctLog
+// 	De-allocate the accounting of the finished threads.
+//----------------------------------------------------------------------
+
+AcctLog::~AcctLog()
+{
+    while (!finished->IsEmpty())
+	delete (AcctRecord *)finished->Remove();
+    delete finished;
+}
+
+//----------------------------------------------------------------------
+// AcctLog::Retire
+// 	Keep the accounting of a thread that is being deleted, so that it
+//	can go in the report.
+//----------------------------------------------------------------------
+
+void
+AcctLog::Retire(Thread *thread)
+{
+    finished->Append((void *)new AcctRecord(thread));
+}
+
+//----------------------------------------------------------------------
+// AcctLog::Print
+// 	Print a table of every thread's accounting, finished threads
+//	first, in the order they finished, then the threads that are
+//	still around, by thread ID.  Under each thread, list how long it
+//	was blocked on each object.  If asked for, write the same
+//	report to a CSV file as well, one line per thread.
+//----------------------------------------------------------------------
+
+static FILE *csv;			// where PrintAcct writes CSV lines
+
+static void
+PrintAcct(char *name, int tid, char *state, ThreadAcct *acct)
+{
+    WaitRecord *rec;
+
+    printf("%5d %-16s %-7s %7d %7d %7d %7d %6d %6d\n", tid, name, state,
+	   acct->userTicks, acct->systemTicks, acct->readyTicks,
+	   acct->blockedTicks, acct->voluntary, acct->involuntary);
+    for (rec = acct->waitList; rec != NULL; rec = rec->next)
+	printf("%30s blocked on \"%s\": %d ticks, %d waits\n", "",
+	       rec->name, rec->ticks, rec->waits);
+
+    if (csv == NULL)
+	return;
+    fprintf(csv, "%d,\"%s\",%s,%d,%d,%d,%d,%d,%d,\"", tid, name, state,
+	    acct->userTicks, acct->systemTicks, acct->readyTicks,
+	    acct->blockedTicks, acct->voluntary, acct->involuntary);
+    for (rec = acct->waitList; rec != NULL; rec = rec->next)
+	fprintf(csv, "%s%s:%d", (rec == acct->waitList) ? "" : ";",
+		rec->name, rec->ticks);
+    fprintf(csv, "\"\n");
+}
+
+static void
+PrintFinished(int arg)
+{
+    AcctRecord *rec = (AcctRecord *)arg;
+
+    PrintAcct(rec->name, rec->tid, "done", &rec->acct);
+}
+
+static void
+PrintLive(int arg)
+{
+    Thread *thread = (Thread *)arg;
+    static char *states[] = { "new", "running", "ready", "blocked" };
+
+    PrintAcct(thread->getName(), thread->getTid(),
+	      states[thread->getStatus()], &thread->acct);
+}
+
+void
+AcctLog::Print()
+{
+    csv = NULL;
+    if (csvFile != NULL && (csv = fopen(csvFile, "w")) == NULL)
+	printf("Can't open accounting file \"%s\"\n", csvFile);
+    if (csv != NULL)
+	fprintf(csv, "tid,name,state,user,system,ready,blocked,"
+		"voluntary,involuntary,waits\n");
+
+    printf("Thread accounting (ticks):\n");
+    printf("%5s %-16s %-7s %7s %7s %7s %7s %6s %6s\n", "tid", "name",
+	   "state", "user", "system", "ready", "blocked", "vol", "invol");
+    finished->Mapcar(PrintFinished);
+    threadTable->Mapcar(PrintLive);
+
+    if (csv != NULL)
+	fclose(csv);
+}
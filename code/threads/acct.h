@@ -0,0 +1,96 @@
+// acct.h
+//	Data structures for per-thread CPU accounting.
+//
+//	Every thread keeps a ThreadAcct, which follows it through its
+//	life: how many ticks it ran in user and in kernel mode, how often
+//	it gave up the CPU on its own (blocking or yielding) and how
+//	often it was made to (time slice or preemption), how long it sat
+//	on a ready queue, and how long it was blocked on each semaphore
+//	or condition variable, by name.
+//
+//	The counting is always done, since it is only a few additions per
+//	context switch.  The report is only kept and printed if asked
+//	for, with "-acct" (see AcctLog).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ACCT_H
+#define ACCT_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "list.h"
+
+class Thread;
+
+// The following class records how long a thread was blocked on one
+// synchronization object.  A thread's records are kept on a short
+// list, in the order it first blocked on each object.
+
+class WaitRecord {
+  public:
+    WaitRecord(char *n) { name = n; ticks = waits = 0; next = NULL; }
+
+    char *name;			// the semaphore or condition waited on
+    int ticks;			// total time spent blocked on it
+    int waits;			// number of times blocked on it
+    WaitRecord *next;
+};
+
+// The following class defines the accounting for one thread.  The
+// fields are public, since they are just statistics.
+
+class ThreadAcct {
+  public:
+    ThreadAcct();			// all counts start at zero
+    ~ThreadAcct();			// de-allocate the wait records
+
+    void Tick(int ticks, bool system);	// the thread ran for "ticks"
+    void Switched(bool forced);		// the thread gave up the CPU
+    void Ready();			// the thread went on a ready queue
+    void Running();			// ...and came off it to run
+    void Blocking(char *on);		// the thread is about to block on
+					// the named object
+    void Woken();			// ...and has been made ready again
+
+    int userTicks;			// time running user code
+    int systemTicks;			// time running in the kernel
+    int voluntary;			// times it blocked, yielded, or
+					// finished
+    int involuntary;			// times it was switched out on a
+					// time slice or a preemption
+    int readyTicks;			// total time on a ready queue
+    int blockedTicks;			// total time blocked
+    WaitRecord *waitList;		// blocked time by object
+    bool preempted;			// set while the thread is being
+					// switched out against its will
+
+  private:
+    int readySince;			// when it went on the ready queue,
+					// or -1 if it isn't there
+    char *blockedOn;			// what it is blocked on, or NULL
+    int blockedSince;			// and since when
+};
+
+// The following class keeps the accounting of threads after they have
+// finished, and prints the report for all threads, finished or not,
+// when Nachos halts.
+
+class AcctLog {
+  public:
+    AcctLog(char *csvName);		// "csvName" is a file to write the
+					// report to as CSV, or NULL
+    ~AcctLog();
+
+    void Retire(Thread *thread);	// "thread" is being deleted; keep
+					// its accounting
+    void Print();			// print the report
+
+  private:
+    List *finished;			// accounting of finished threads
+    char *csvFile;			// where to write the CSV, if anywhere
+};
+
+#endif // ACCT_H
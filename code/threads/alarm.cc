@@ -0,0 +1,84 @@
+// alarm.cc
+//	Routines to put threads to sleep for a while, and to wake them
+//	up when the time is up.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "alarm.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Alarm::Alarm
+// 	Initialize the alarm clock, with no one asleep.
+//----------------------------------------------------------------------
+
+Alarm::Alarm()
+{
+    wheel = new TimerWheel;
+}
+
+//----------------------------------------------------------------------
+// Alarm::~Alarm
+// 	De-allocate the alarm clock.  Any threads still asleep are simply
+//	forgotten.
+//----------------------------------------------------------------------
+
+Alarm::~Alarm()
+{
+    delete wheel;
+}
+
+//----------------------------------------------------------------------
+// Alarm::Pause
+// 	Put the current thread to sleep until at least "howLong" ticks
+//	from now, at the first timer interrupt after that.
+//
+//	The thread's timeout lives on its own stack, which stays put
+//	while the thread sleeps.
+//----------------------------------------------------------------------
+
+void
+Alarm::Pause(int howLong)
+{
+    WheelNode node;
+
+    if (howLong <= 0)
+	return;
+
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    node.item = (void *)currentThread;
+    wheel->Insert(&node, divRoundUp(stats->totalTicks + howLong, TimerTicks));
+    DEBUG('t', "Thread \"%s\" sleeping until period %d\n", 
+	  currentThread->getName(), node.expires);
+    currentThread->acct.Blocking("alarm");
+    currentThread->Sleep();
+
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::CallBack
+// 	Called by the timer interrupt handler, with interrupts disabled.
+//	Bring the wheel up to the current time, and put every thread
+//	whose time has come back on the ready queue.
+//----------------------------------------------------------------------
+
+void
+Alarm::CallBack()
+{
+    while (wheel->Now() < stats->totalTicks / TimerTicks) {
+	WheelNode *node = wheel->Advance();
+
+	while (node != NULL) {
+	    WheelNode *next = node->next;	// the thread may run, and
+						// its node go away, any 
+						// time after ReadyToRun
+	    scheduler->ReadyToRun((Thread *)node->item);
+	    node = next;
+	}
+    }
+}
@@ -0,0 +1,43 @@
+// alarm.h
+//	Data structures for a software alarm clock, which lets a thread
+//	go to sleep for a given amount of simulated time.
+//
+//	The alarm is driven by the hardware timer: on every timer 
+//	interrupt, it wakes up the threads whose time has come.  So a
+//	thread sleeps for at least as long as it asked, rounded up to 
+//	the next timer interrupt, and takes no CPU time meanwhile.
+//
+//	The sleeping threads are kept on a timer wheel (see timerwheel.h),
+//	so however many there are, putting a thread to sleep and waking 
+//	it up take constant time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "timerwheel.h"
+
+// The following class defines the alarm clock.
+
+class Alarm {
+  public:
+    Alarm();			// initialize the alarm, with no one asleep
+    ~Alarm();
+
+    void Pause(int howLong);	// put the current thread to sleep for 
+				// "howLong" ticks
+    void CallBack();		// called on every timer interrupt, to 
+				// wake up threads whose time has come
+    bool IsEmpty() { return wheel->IsEmpty(); }	// is no one asleep?
+
+  private:
+    TimerWheel *wheel;		// the sleeping threads, by wake-up time,
+				// counted in timer interrupts
+};
+
+#endif // ALARM_H
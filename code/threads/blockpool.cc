@@ -0,0 +1,135 @@
+// blockpool.cc 
+//	Routines to recycle fixed-size blocks of memory.
+//
+//	NOTE: Mutual exclusion must be provided by the caller.  Thread
+//	control blocks and stacks are allocated and freed with interrupts
+//	disabled, or before any other thread exists.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "blockpool.h"
+
+//----------------------------------------------------------------------
+// BlockPool::BlockPool
+// 	Initialize a pool, with no free blocks to start with.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"blockSize" is the size of every block, in bytes.
+//	"maxFree" is the most free blocks to keep around; 0 means
+//		every block goes straight back to the system.
+//	"isBounded" is TRUE if blocks should have guard pages around them.
+//----------------------------------------------------------------------
+
+BlockPool::BlockPool(char *debugName, int blockSize, int maxFree, 
+		     bool isBounded)
+{
+    ASSERT(blockSize >= (int) sizeof(char *) && maxFree >= 0);
+    name = debugName;
+    size = blockSize;
+    highWater = maxFree;
+    bounded = isBounded;
+    freeList = NULL;
+    numFree = 0;
+    gets = hits = releases = 0;
+}
+
+//----------------------------------------------------------------------
+// BlockPool::~BlockPool
+// 	Give every block on the free list back to the system.  Blocks 
+//	that are still in use are the caller's problem.
+//----------------------------------------------------------------------
+
+BlockPool::~BlockPool()
+{
+    while (freeList != NULL) {
+	char *block = freeList;
+
+	freeList = *(char **) block;
+	Release(block);
+    }
+}
+
+//----------------------------------------------------------------------
+// BlockPool::Allocate, BlockPool::Release
+// 	Get a new block from the system, or give one back.
+//----------------------------------------------------------------------
+
+char *
+BlockPool::Allocate()
+{
+    if (bounded)
+	return AllocBoundedArray(size);
+    return new char[size];
+}
+
+void
+BlockPool::Release(char *block)
+{
+    if (bounded)
+	DeallocBoundedArray(block, size);
+    else
+	delete [] block;
+}
+
+//----------------------------------------------------------------------
+// BlockPool::Get
+// 	Return a block of memory, taking it off the free list if there 
+//	is one there, otherwise getting a new one from the system.
+//	The contents of the block are garbage.
+//----------------------------------------------------------------------
+
+char *
+BlockPool::Get()
+{
+    char *block;
+
+    gets++;
+    if (freeList == NULL)
+	return Allocate();
+
+    hits++;
+    block = freeList;
+    freeList = *(char **) block;
+    numFree--;
+    return block;
+}
+
+//----------------------------------------------------------------------
+// BlockPool::Put
+// 	Recycle a block, by putting it on the free list -- unless there 
+//	are already "highWater" blocks there, in which case it goes back
+//	to the system.
+//
+//	"block" is a block returned by Get.
+//----------------------------------------------------------------------
+
+void
+BlockPool::Put(char *block)
+{
+    if (numFree >= highWater) {
+	releases++;
+	Release(block);
+	return;
+    }
+    *(char **) block = freeList;
+    freeList = block;
+    numFree++;
+}
+
+//----------------------------------------------------------------------
+// BlockPool::Print
+// 	Print how many requests were met from the free list, at system
+//	shutdown.
+//----------------------------------------------------------------------
+
+void
+BlockPool::Print()
+{
+    printf("%s pool: %d requests, %d hits (%.1f%%), %d allocated, "
+	   "%d released, %d free (high water %d)\n", name, gets, hits, 
+	   (gets == 0) ? 0.0 : 100.0 * hits / gets, gets - hits, releases,
+	   numFree, highWater);
+}
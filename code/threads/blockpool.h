@@ -0,0 +1,58 @@
+// blockpool.h 
+//	Data structures for recycling fixed-size blocks of memory, so that
+//	objects which are created and destroyed over and over (thread
+//	control blocks and thread stacks) don't go back to the system 
+//	allocator each time.
+//
+//	A freed block is kept on the pool's free list, up to a high-water 
+//	mark; beyond that it is given back to the system.  The free list 
+//	is threaded through the first word of the free blocks themselves,
+//	so the pool never allocates anything of its own.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BLOCKPOOL_H
+#define BLOCKPOOL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define DefaultPoolHighWater	32	// free blocks kept by each pool,
+					// unless changed with "-pool"
+
+// The following class defines a pool of equal-sized blocks.  If 
+// "bounded" is TRUE, blocks come from AllocBoundedArray, so each has
+// guard pages around it -- that's what thread stacks want.
+
+class BlockPool {
+  public:
+    BlockPool(char *debugName, int blockSize, int maxFree, bool isBounded);
+					// initialize an empty pool
+    ~BlockPool();			// give every free block back
+
+    char *Get();			// a block, recycled if possible
+    void Put(char *block);		// done with a block from Get
+
+    void Print();			// print how well the pool did
+
+  private:
+    char *name;				// useful for debugging
+    int size;				// bytes in each block
+    int highWater;			// most blocks to keep on the free list
+    bool bounded;			// use AllocBoundedArray?
+
+    char *freeList;			// recycled blocks, linked through
+					// their first word
+    int numFree;			// blocks on the free list
+
+    int gets, hits;			// requests, and how many were met 
+					// from the free list
+    int releases;			// blocks given back to the system
+
+    char *Allocate();			// get a new block from the system
+    void Release(char *block);		// give a block back to the system
+};
+
+#endif // BLOCKPOOL_H
@@ -0,0 +1,431 @@
+// cpu.cc 
+//	Routines to simulate several CPUs, taking turns one tick at a 
+//	time, each with its own ready queue.
+//
+//	With only one CPU (the default), none of this changes how Nachos
+//	behaves: the one CPU always has the next turn, and it never has
+//	anyone to steal from.
+//
+//	NOTE: all of these routines except the constructor assume that
+//	interrupts are disabled.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cpu.h"
+#include "switch.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Cpu::Cpu
+// 	Initialize a simulated CPU, idle to start with.
+//
+//	"cpuId" is the CPU's number.
+//	"policy" is the scheduling policy for its ready queue.
+//	"slice" is how it decides on the length of time slices.
+//----------------------------------------------------------------------
+
+Cpu::Cpu(int cpuId, SchedPolicy policy, SlicePolicy slice)
+{
+    id = cpuId;
+    current = NULL;
+    scheduler = new Scheduler(policy, slice);
+    deque = new WorkDeque;
+    needResched = FALSE;
+    busyTicks = steals = 0;
+}
+
+//----------------------------------------------------------------------
+// Cpu::~Cpu
+// 	De-allocate a CPU's ready queue.
+//----------------------------------------------------------------------
+
+Cpu::~Cpu()
+{
+    delete scheduler;
+    delete deque;
+}
+
+//----------------------------------------------------------------------
+// Cpu::NoteRun
+// 	Keep track of how often threads come back to the CPU they last 
+//	ran on, which is when they are likely to find their data still 
+//	in its cache.
+//
+//	"thread" is about to start running on this CPU.
+//----------------------------------------------------------------------
+
+void
+Cpu::NoteRun(Thread *thread)
+{
+    if (thread->getLastCpu() >= 0) {	// not its first time
+	stats->numResumes++;
+	if (thread->getLastCpu() == id)
+	    stats->numLocalResumes++;
+    }
+    thread->setLastCpu(id);
+}
+
+//----------------------------------------------------------------------
+// CpuSet::CpuSet
+// 	Initialize a set of CPUs, all idle.  CPU 0 is the one being 
+//	simulated to start with.
+//
+//	"n" is the number of CPUs.
+//	"policy" is the scheduling policy for each CPU's ready queue.
+//	"slice" is how the CPUs decide on the length of time slices.
+//----------------------------------------------------------------------
+
+CpuSet::CpuSet(int n, SchedPolicy policy, SlicePolicy slice)
+{
+    ASSERT(n >= 1 && n <= MaxCpus);
+    numCpus = n;
+    for (int i = 0; i < numCpus; i++)
+	cpus[i] = new Cpu(i, policy, slice);
+}
+
+//----------------------------------------------------------------------
+// CpuSet::~CpuSet
+// 	De-allocate the CPUs.
+//----------------------------------------------------------------------
+
+CpuSet::~CpuSet()
+{
+    for (int i = 0; i < numCpus; i++)
+	delete cpus[i];
+}
+
+//----------------------------------------------------------------------
+// CpuSet::HasWork
+// 	Return TRUE if "cpu" is running a thread, or could start running
+//	one: its own ready queue, or some other CPU's, is not empty.
+//----------------------------------------------------------------------
+
+bool
+CpuSet::HasWork(Cpu *cpu)
+{
+    if (cpu->current != NULL)
+	return TRUE;
+    for (int i = 0; i < numCpus; i++)
+	if (!cpus[i]->scheduler->IsEmpty() || !cpus[i]->deque->IsEmpty())
+	    return TRUE;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// CpuSet::NextCpu
+// 	Return the next CPU after "cpu", in order of CPU number, that 
+//	has something to do, or NULL if there is none.  "cpu" itself is
+//	never returned.
+//
+//	"wrap" is TRUE if we should wrap around to CPU 0, rather than 
+//		stopping at the last CPU.
+//----------------------------------------------------------------------
+
+Cpu *
+CpuSet::NextCpu(Cpu *cpu, bool wrap)
+{
+    int last = wrap ? cpu->id + numCpus : numCpus;
+
+    for (int i = cpu->id + 1; i < last; i++)
+	if (HasWork(cpus[i % numCpus]))
+	    return cpus[i % numCpus];
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// CpuSet::Steal
+// 	Take a thread from another CPU, trying the CPUs in order starting
+//	after the thief.  Threads that have never run (the oldest one on
+//	a deque) are taken in preference to those on a ready queue, 
+//	which have run, and so have data in their CPU's cache.  Return
+//	NULL if there is nothing to steal.
+//
+//	"thief" is the CPU that has run out of work.
+//----------------------------------------------------------------------
+
+Thread *
+CpuSet::Steal(Cpu *thief)
+{
+    Thread *thread = NULL;
+    Cpu *victim;
+    int i;
+
+    for (i = 1; i < numCpus && thread == NULL; i++) {
+	victim = cpus[(thief->id + i) % numCpus];
+	thread = victim->deque->Steal();
+    }
+    for (i = 1; i < numCpus && thread == NULL; i++) {
+	victim = cpus[(thief->id + i) % numCpus];
+	thread = victim->scheduler->FindNextToRun(victim->current);
+    }
+    if (thread == NULL)
+	return NULL;
+
+    DEBUG('t', "CPU %d steals thread \"%s\" from CPU %d\n", 
+	  thief->id, thread->getName(), victim->id);
+    thief->steals++;
+    stats->numSteals++;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// CpuSet::FindWork
+// 	Return the next thread for "cpu" to run, local work first: the
+//	newest thread on its own deque, then the first one on its own 
+//	ready queue, and only then one stolen from another CPU.  Return 
+//	NULL if there are no ready threads anywhere.
+//----------------------------------------------------------------------
+
+Thread *
+CpuSet::FindWork(Cpu *cpu)
+{
+    Thread *thread = cpu->deque->PopBottom();
+
+    if (thread == NULL)
+	thread = cpu->scheduler->FindNextToRun(cpu->current);
+    if (thread == NULL)
+	thread = Steal(cpu);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// CpuSet::FindNextToRun
+// 	Return the next thread for the current CPU to run, or NULL if
+//	there are no ready threads anywhere.
+//----------------------------------------------------------------------
+
+Thread *
+CpuSet::FindNextToRun()
+{
+    return FindWork(currentCpu);
+}
+
+//----------------------------------------------------------------------
+// CpuSet::ReadyToRunNew
+// 	Make a newly forked thread ready to run.  With more than one CPU,
+//	under SCHED_FIFO, it goes on the bottom of the current CPU's 
+//	deque, from which idle CPUs can steal it.  Otherwise it goes on
+//	the ready queue like any other thread: the other policies have to
+//	set up its virtual runtime or pass, check whether it preempts the
+//	running thread, and keep it in order with the threads already 
+//	ready, none of which a deque would do.
+//----------------------------------------------------------------------
+
+void
+CpuSet::ReadyToRunNew(Thread *thread)
+{
+    if (numCpus == 1 || scheduler->getPolicy() != SCHED_FIFO) {
+	scheduler->ReadyToRun(thread);
+	return;
+    }
+    DEBUG('t', "Putting new thread %s on CPU %d's deque.\n", 
+	  thread->getName(), currentCpu->id);
+    thread->setStatus(READY);
+    currentCpu->deque->PushBottom(thread);
+}
+
+//----------------------------------------------------------------------
+// CpuSet::ChangePrio
+// 	Change a thread's priority, wherever the thread is.  If it is 
+//	running on the current CPU, or waiting on some CPU's ready queue,
+//	that CPU's scheduler has to keep its queue in order (see 
+//	Scheduler::ChangePrio).  A ready thread whose priority goes up 
+//	may now preempt the thread running on its CPU.  A thread that is
+//	blocked, waiting on a deque, or running on another CPU just gets
+//	the new priority.
+//
+//	"thread" is the thread whose priority changes.
+//	"prio" is its new priority.
+//----------------------------------------------------------------------
+
+void
+CpuSet::ChangePrio(Thread *thread, int prio)
+{
+    if (thread == currentThread) {
+	scheduler->ChangePrio(thread, prio);
+	return;
+    }
+    if (thread->getStatus() == READY)
+	for (int i = 0; i < numCpus; i++) {
+	    Cpu *cpu = cpus[i];
+
+	    if (!cpu->scheduler->ChangePrio(thread, prio))
+		continue;
+	    if (cpu->scheduler->CheckPreempt(thread, cpu->current)) {
+		if (cpu == currentCpu)
+		    scheduler->SwitchSoon();
+		else
+		    cpu->needResched = TRUE;
+	    }
+	    return;
+	}
+    thread->setPrio(prio);
+}
+
+//----------------------------------------------------------------------
+// CpuSet::Idle
+// 	Called when the thread on the current CPU blocks, and there is
+//	no ready thread to take its place.  The CPU goes idle; if some 
+//	other CPU is still running a thread, switch to simulating it.
+//
+//	Returns TRUE when the blocked thread has been woken up and is 
+//	running again (on whichever CPU picked it up), or FALSE at once
+//	if there is no other CPU to switch to, in which case the caller 
+//	must wait for an interrupt.
+//----------------------------------------------------------------------
+
+bool
+CpuSet::Idle()
+{
+    Cpu *next = NextCpu(currentCpu, TRUE);
+
+    currentCpu->current = NULL;
+    if (next == NULL)
+	return FALSE;
+    Switch(next);
+
+    // we've been woken up, and some CPU has switched back to us, from
+    // Run or after Dispatch; start a fresh time slice, as Run does
+    currentThread->resetUsedtime();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// CpuSet::EndOfRound
+// 	Return TRUE if the current CPU is the last one with something to 
+//	do, so that once it has had its turn, simulated time should 
+//	advance.
+//----------------------------------------------------------------------
+
+bool
+CpuSet::EndOfRound()
+{
+    return (NextCpu(currentCpu, FALSE) == NULL);
+}
+
+//----------------------------------------------------------------------
+// CpuSet::NextTurn
+// 	Switch to simulating the next CPU with something to do, wrapping
+//	around after the last one.  Returns when the current thread gets
+//	its next turn, which may be on a different CPU if the thread was 
+//	preempted and stolen meanwhile.
+//----------------------------------------------------------------------
+
+void
+CpuSet::NextTurn()
+{
+    Cpu *next = NextCpu(currentCpu, TRUE);
+
+    if (next != NULL)
+	Switch(next);
+}
+
+//----------------------------------------------------------------------
+// CpuSet::Switch
+// 	Start simulating "cpu", by switching to the thread running 
+//	on it.  If "cpu" is idle, it first picks a thread to run.
+//
+//	The thread we are switching away from stays where it is: still
+//	running on its CPU (if it's just had its turn), or blocked.
+//----------------------------------------------------------------------
+
+void
+CpuSet::Switch(Cpu *cpu)
+{
+    Thread *oldThread = currentThread;
+
+    if (cpu->current == NULL) {
+	Thread *thread = FindWork(cpu);
+
+	ASSERT(thread != NULL);
+	cpu->scheduler->Dispatch(thread);
+	cpu->NoteRun(thread);
+	cpu->current = thread;
+    }
+
+    // the one machine is shared by all the CPUs, so the old thread's 
+    // user registers are handled as for a context switch: they stay 
+    // in the machine until the next user thread is restored
+    oldThread->CheckOverflow();
+
+    DEBUG('t', "Switching from CPU %d (\"%s\") to CPU %d (\"%s\")\n",
+	  currentCpu->id, oldThread->getName(), cpu->id, 
+	  cpu->current->getName());
+    currentCpu = cpu;
+    scheduler = cpu->scheduler;
+    currentThread = cpu->current;
+    SWITCH(oldThread, currentThread);
+
+    scheduler->Reap();
+#ifdef USER_PROGRAM
+    if (currentThread->space != NULL) {
+        currentThread->RestoreUserState();
+	currentThread->space->RestoreState();
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// CpuSet::Tick
+// 	Account for simulated time advancing, on every CPU at once.  
+//	Threads running in the kernel are charged for the time, for 
+//	time slicing.
+//
+//	"ticks" is how much time has passed.
+//	"system" is TRUE if the machine is in kernel mode.
+//----------------------------------------------------------------------
+
+void
+CpuSet::Tick(int ticks, bool system)
+{
+    for (int i = 0; i < numCpus; i++) {
+	if (cpus[i]->current == NULL)
+	    continue;
+	cpus[i]->busyTicks += ticks;
+	cpus[i]->current->acct.Tick(ticks, system);
+	if (system)
+	    cpus[i]->current->addTime();
+    }
+}
+
+//----------------------------------------------------------------------
+// CpuSet::TimerTick
+// 	Called from the timer interrupt handler, which takes care of the
+//	current CPU; pass the tick on to every other busy CPU's scheduler.
+//	A CPU whose thread should give up the processor does so at the 
+//	start of its next turn.
+//----------------------------------------------------------------------
+
+void
+CpuSet::TimerTick()
+{
+    for (int i = 0; i < numCpus; i++) {
+	Cpu *cpu = cpus[i];
+
+	if (cpu != currentCpu && cpu->current != NULL
+		&& cpu->scheduler->TimerTick(cpu->current))
+	    cpu->needResched = TRUE;
+    }
+}
+
+//----------------------------------------------------------------------
+// CpuSet::Print
+// 	Print per-CPU statistics at system shutdown, followed by each
+//	CPU's scheduler statistics, and the CPU share of each thread.
+//----------------------------------------------------------------------
+
+void
+CpuSet::Print()
+{
+    if (numCpus > 1)
+	for (int i = 0; i < numCpus; i++)
+	    printf("CPU %d: busy %d, idle %d, threads stolen %d\n", i, 
+		   cpus[i]->busyTicks, stats->totalTicks - cpus[i]->busyTicks,
+		   cpus[i]->steals);
+    for (int i = 0; i < numCpus; i++)
+	cpus[i]->scheduler->PrintStats();
+    Scheduler::PrintShares();
+}
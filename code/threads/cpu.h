@@ -0,0 +1,109 @@
+// cpu.h 
+//	Data structures to simulate a shared-memory multiprocessor.
+//
+//	Each simulated CPU has its own running thread and its own ready 
+//	queue (a Scheduler of its own).  The global "currentThread" and 
+//	"scheduler" always refer to the CPU being simulated at the 
+//	moment, "currentCpu", so the rest of the kernel doesn't need to 
+//	know how many CPUs there are.  A thread made ready goes on the 
+//	ready queue of the CPU that readied it.
+//
+//	With more than one CPU, under SCHED_FIFO, a newly forked thread 
+//	instead goes on the forking CPU's work-stealing deque (see 
+//	workdeque.h), where it waits for its first turn.  The other 
+//	policies order their ready queues, so new threads must take their
+//	place there, like any other ready thread.
+//
+//	The CPUs take turns, one tick each, in order of CPU number: every 
+//	time interrupts are re-enabled (Interrupt::OneTick), the next 
+//	busy CPU gets to run, and simulated time advances once all of 
+//	them have had their turn.  A CPU whose ready queue is empty 
+//	steals a thread from another CPU's queue; if there is nothing to
+//	steal, it sits idle until there is.  The interleaving is 
+//	completely deterministic.
+//
+//	A CPU looking for work tries, in order: the newest thread on its
+//	own deque, its own ready queue, the oldest thread on another 
+//	CPU's deque, and finally another CPU's ready queue.  Local work 
+//	comes first, so that threads tend to stay on the CPU whose cache
+//	already holds their data (and address space).
+//
+//	Since the CPUs only change turns when interrupts are re-enabled,
+//	disabling interrupts on one CPU keeps all the others out -- it
+//	acts as one big kernel lock, as on the original uniprocessor.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "copyright.h"
+#include "scheduler.h"
+#include "workdeque.h"
+
+#define MaxCpus		32		// most CPUs we can simulate
+
+// The following class defines one simulated CPU.  The fields are 
+// public, since they are mostly statistics.
+
+class Cpu {
+  public:
+    Cpu(int cpuId, SchedPolicy policy, SlicePolicy slice);
+					// initialize an idle CPU
+    ~Cpu();				// de-allocate its ready queue
+
+    int id;				// CPU number, from 0
+    Thread *current;			// thread running here, NULL if idle
+    Scheduler *scheduler;		// this CPU's ready queue
+    WorkDeque *deque;			// threads forked on this CPU
+    bool needResched;			// time slice expired while another
+					// CPU was being simulated
+
+    int busyTicks;			// time spent running a thread
+    int steals;				// threads taken from other CPUs
+
+    void NoteRun(Thread *thread);	// "thread" is starting to run here
+};
+
+// The following class defines the set of all CPUs in the machine,
+// and decides which one is being simulated at any given moment.
+
+class CpuSet {
+  public:
+    CpuSet(int n, SchedPolicy policy, SlicePolicy slice);
+					// initialize "n" idle CPUs
+    ~CpuSet();
+
+    int NumCpus() { return numCpus; }
+    Cpu *GetCpu(int i) { return cpus[i]; }
+
+    void ReadyToRunNew(Thread *thread);	// a newly forked thread is ready
+    void ChangePrio(Thread *thread, int prio);	// change a thread's 
+					// priority, wherever it is
+    Thread *FindNextToRun();		// next thread for the current CPU:
+					// its own, or one stolen
+    bool Idle();			// current CPU has nothing to do; 
+					// let another CPU run instead
+    bool EndOfRound();			// has every busy CPU had its turn?
+    void NextTurn();			// switch to the next CPU's turn
+    void Tick(int ticks, bool system);	// account for a tick of time
+    void TimerTick();			// time slice the other CPUs
+
+    void Print();			// print per-CPU statistics
+
+  private:
+    Cpu *cpus[MaxCpus];
+    int numCpus;
+
+    Cpu *NextCpu(Cpu *cpu, bool wrap);	// next CPU after "cpu" with 
+					// something to do, or NULL
+    bool HasWork(Cpu *cpu);		// could "cpu" run a thread?
+    Thread *FindWork(Cpu *cpu);		// next thread for "cpu" to run
+    Thread *Steal(Cpu *thief);		// take a ready thread from 
+					// another CPU
+    void Switch(Cpu *cpu);		// start simulating "cpu"
+};
+
+#endif // CPU_H
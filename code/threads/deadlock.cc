@@ -0,0 +1,116 @@
+// deadlock.cc
+//	Routines to find deadlocks among threads waiting for locks and
+//	semaphores, as each thread blocks.
+//
+//	NOTE: Blocking is called with interrupts disabled, just before
+//	the thread goes to sleep, so the graph can't change under it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "deadlock.h"
+#include "synch.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// DeadlockDetector::DeadlockDetector
+// 	Initialize the detector; no thread has blocked yet.
+//----------------------------------------------------------------------
+
+DeadlockDetector::DeadlockDetector()
+{
+    checks = found = 0;
+}
+
+//----------------------------------------------------------------------
+// DeadlockDetector::WaitsFor
+// 	Return the thread that "thread" is waiting for: the holder of the
+//	lock it is waiting to acquire, or of the semaphore it is waiting
+//	on, if that semaphore is used as a mutex.  Return NULL if it
+//	isn't waiting for any one thread.
+//----------------------------------------------------------------------
+
+Thread *
+DeadlockDetector::WaitsFor(Thread *thread)
+{
+    if (thread->waitingOn != NULL)
+	return thread->waitingOn->cur;
+    if (thread->waitingSema != NULL)
+	return thread->waitingSema->holder;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// DeadlockDetector::Blocking
+// 	"thread" has just been put on the queue of the lock or semaphore
+//	it is about to wait for.  Follow the chain of threads waiting for
+//	each other from there; if it comes back to "thread", report the
+//	deadlock.
+//----------------------------------------------------------------------
+
+void
+DeadlockDetector::Blocking(Thread *thread)
+{
+    Thread *next = WaitsFor(thread);
+
+    checks++;
+    for (int steps = threadTable->NumThreads(); next != NULL && steps > 0;
+	 steps--) {
+	if (next == thread) {
+	    found++;
+	    Report(thread);
+	    return;
+	}
+	next = WaitsFor(next);
+    }
+}
+
+//----------------------------------------------------------------------
+// DeadlockDetector::Report
+// 	Print the cycle of deadlocked threads that goes through "thread":
+//	for each, the locks it holds and what it is waiting for.  We 
+//	don't know every semaphore a thread holds, only those it holds
+//	as a mutex, that the thread before it in the cycle waits for.
+//----------------------------------------------------------------------
+
+void
+DeadlockDetector::Report(Thread *thread)
+{
+    Thread *t = thread;
+    Thread *prev;
+
+    for (prev = thread; WaitsFor(prev) != thread; prev = WaitsFor(prev))
+	;
+    printf("Deadlock at tick %d:\n", stats->totalTicks);
+    do {
+	printf("  thread \"%s\" (%d) holds", t->getName(), t->getTid());
+	for (Lock *lock = t->heldLocks; lock != NULL; lock = lock->nextHeld)
+	    printf(" lock \"%s\"", lock->getName());
+	if (prev->waitingSema != NULL)
+	    printf(" semaphore \"%s\"", prev->waitingSema->getName());
+	prev = t;
+	if (t->waitingOn != NULL)
+	    printf(",\n    waits in Acquire for lock \"%s\"",
+		   t->waitingOn->getName());
+	else
+	    printf(",\n    waits in P for semaphore \"%s\"",
+		   t->waitingSema->getName());
+	t = WaitsFor(t);
+	printf(", held by \"%s\"\n", t->getName());
+    } while (t != thread);
+}
+
+//----------------------------------------------------------------------
+// DeadlockDetector::Print
+// 	Print how many blocking threads were checked, and how many
+//	deadlocks were found, when Nachos halts.
+//----------------------------------------------------------------------
+
+void
+DeadlockDetector::Print()
+{
+    printf("Deadlock detector: %d waits checked, %d deadlocks found\n",
+	   checks, found);
+}
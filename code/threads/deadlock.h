@@ -0,0 +1,60 @@
+// deadlock.h
+//	Data structures for finding deadlocks among threads waiting for
+//	locks and semaphores.
+//
+//	The wait-for graph is kept in the threads and the objects they
+//	wait for: a thread waiting in Lock::Acquire points to the lock
+//	(Thread::waitingOn), and the lock to its holder; a thread waiting
+//	in Semaphore::P points to the semaphore (Thread::waitingSema).  A
+//	semaphore has no holder in general -- any thread may V it -- so it
+//	is only part of the graph when it is used as a mutex: one created
+//	with value 1 is taken to be held by the thread that last took it
+//	down to 0, until the next V.
+//
+//	A new cycle can only be closed by the edge being added, so when a
+//	thread is about to block, we follow the edges from it; if they
+//	lead back to it, every thread on the way is deadlocked.  Only
+//	threads that block pay, and only for the length of the chain,
+//	which is nearly always one or two.  The walk gives up after as
+//	many steps as there are threads, in case it runs into a cycle
+//	that was found earlier.
+//
+//	The detector is off unless asked for, with "-deadlock".  Each
+//	cycle is reported as it forms, naming the threads in it, the
+//	locks each one holds, and what each one is waiting for.  Nachos
+//	then carries on, since other threads may still have work to do.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef DEADLOCK_H
+#define DEADLOCK_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Thread;
+
+// The following class checks blocking threads for deadlock, and
+// reports the deadlocks it finds.
+
+class DeadlockDetector {
+  public:
+    DeadlockDetector();			// nothing found yet
+
+    void Blocking(Thread *thread);	// "thread" is about to wait;
+					// report a deadlock if that closes
+					// a cycle
+    void Print();			// print how many were found
+
+  private:
+    int checks;				// number of threads checked
+    int found;				// number of deadlocks found
+
+    static Thread *WaitsFor(Thread *thread);	// the thread "thread"
+					// waits for, or NULL
+    void Report(Thread *thread);	// print the cycle through "thread"
+};
+
+#endif // DEADLOCK_H
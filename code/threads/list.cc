@@ -236,3 +236,167 @@ List::SortedRemove(int *keyPtr)
     return thing;
 }
 
+//----------------------------------------------------------------------
+// ListLink::ListLink
+// 	Initialize a link, so it can be put on a LinkList.  The user
+//	sets "item" to the object the link is embedded in.
+//----------------------------------------------------------------------
+
+ListLink::ListLink()
+{
+    item = NULL;
+    key = 0;
+    next = NULL;
+    onList = FALSE;
+}
+
+//----------------------------------------------------------------------
+// LinkList::LinkList
+//	Initialize an intrusive list, empty to start with.
+//----------------------------------------------------------------------
+
+LinkList::LinkList()
+{
+    first = last = NULL;
+}
+
+//----------------------------------------------------------------------
+// LinkList::~LinkList
+//	De-allocate a list.  The links belong to the objects they are
+//	embedded in, so there is nothing to de-allocate; any still on
+//	the list are just marked as being off it.
+//----------------------------------------------------------------------
+
+LinkList::~LinkList()
+{
+    while (Remove() != NULL)
+	;
+}
+
+//----------------------------------------------------------------------
+// LinkList::Append
+//      Put a link at the end of the list.
+//
+//	"link" is the link to put on the list; it must not be on a list
+//		already.
+//----------------------------------------------------------------------
+
+void
+LinkList::Append(ListLink *link)
+{
+    ASSERT(!link->onList);
+    link->onList = TRUE;
+    link->next = NULL;
+    if (IsEmpty())
+	first = link;
+    else
+	last->next = link;
+    last = link;
+}
+
+//----------------------------------------------------------------------
+// LinkList::Prepend
+//      Put a link at the front of the list.
+//
+//	"link" is the link to put on the list; it must not be on a list
+//		already.
+//----------------------------------------------------------------------
+
+void
+LinkList::Prepend(ListLink *link)
+{
+    ASSERT(!link->onList);
+    link->onList = TRUE;
+    link->next = first;
+    if (IsEmpty())
+	last = link;
+    first = link;
+}
+
+//----------------------------------------------------------------------
+// LinkList::Remove
+//      Take the first link off the list.
+//
+// Returns:
+//	The item the link is embedded in, NULL if nothing on the list.
+//----------------------------------------------------------------------
+
+void *
+LinkList::Remove()
+{
+    return SortedRemove(NULL);
+}
+
+//----------------------------------------------------------------------
+// LinkList::Mapcar
+//	Apply a function to the item of each link on the list.
+//
+//	"func" is the procedure to apply to each item.
+//----------------------------------------------------------------------
+
+void
+LinkList::Mapcar(VoidFunctionPtr func)
+{
+    for (ListLink *link = first; link != NULL; link = link->next)
+	(*func)((int)link->item);
+}
+
+//----------------------------------------------------------------------
+// LinkList::SortedInsert
+//      Put a link on the list, so that the links are sorted in 
+//	increasing order by key.  A link goes after any with the same
+//	key, as in List::SortedInsert.
+//
+//	"link" is the link to put on the list; it must not be on a list
+//		already.
+//	"sortKey" is the priority of the link's item.
+//----------------------------------------------------------------------
+
+void
+LinkList::SortedInsert(ListLink *link, int sortKey)
+{
+    ListLink *ptr;
+
+    link->key = sortKey;
+    if (IsEmpty() || sortKey < first->key) {
+	Prepend(link);
+	return;
+    }
+    if (sortKey >= last->key) {		// the common case, for timers
+	Append(link);
+	return;
+    }
+    for (ptr = first; !(sortKey < ptr->next->key); ptr = ptr->next)
+	;
+    ASSERT(!link->onList);
+    link->onList = TRUE;
+    link->next = ptr->next;
+    ptr->next = link;
+}
+
+//----------------------------------------------------------------------
+// LinkList::SortedRemove
+//      Take the first link off a sorted list.
+//
+// Returns:
+//	The item the link is embedded in, NULL if nothing on the list.
+//	Sets *keyPtr to the key of the link removed, if "keyPtr" isn't
+//	NULL.
+//----------------------------------------------------------------------
+
+void *
+LinkList::SortedRemove(int *keyPtr)
+{
+    ListLink *link = first;
+
+    if (IsEmpty())
+	return NULL;
+    first = link->next;
+    if (first == NULL)
+	last = NULL;
+    link->next = NULL;
+    link->onList = FALSE;
+    if (keyPtr != NULL)
+	*keyPtr = link->key;
+    return link->item;
+}
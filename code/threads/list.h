@@ -6,6 +6,13 @@
 //	pending interrupts, etc.  That is why each item is a "void *",
 //	or in other words, a "pointers to anything".
 //
+//	List allocates a ListElement for every item it holds.  The
+//	kernel's own queues -- the ready list, the threads waiting on a
+//	semaphore or condition variable, the pending interrupts -- use a
+//	LinkList instead, which allocates nothing: as with RBTree, the 
+//	caller embeds a ListLink in each object it wants to keep on a
+//	list, and the object can be on one list per ListLink it has.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -63,4 +70,47 @@ class List {
     ListElement *last;		// Last element of list
 };
 
+// The following class defines a link of an intrusive list.  The 
+// fields are public so the list routines can get at them directly;
+// users should only set "item", and only while the link is not on a
+// list.
+
+class ListLink {
+  public:
+    ListLink();			// initialize a link, not on any list
+
+    void *item;			// the object this link is embedded in
+    int key;			// priority, for a sorted list
+    ListLink *next;		// next link on the list, NULL if last
+    bool onList;		// TRUE while the link is on a list
+};
+
+// The following class defines an intrusive list -- a singly linked
+// list of ListLinks, with the same operations as List, but taking the
+// link to put on the list rather than the item.
+
+class LinkList {
+  public:
+    LinkList();			// initialize the list, empty to start with
+    ~LinkList();		// de-allocate the list (not the links!)
+
+    void Prepend(ListLink *link);	// put link at the front of the list
+    void Append(ListLink *link);	// put link at the end of the list
+    void *Remove();		// take the first link off the list, and
+				// return its item; NULL if empty
+
+    void Mapcar(VoidFunctionPtr func);	// apply "func" to the item of
+					// every link on the list
+    bool IsEmpty() { return (first == NULL); }
+
+    void SortedInsert(ListLink *link, int sortKey);	// put link on the
+				// list, in increasing order by key
+    void *SortedRemove(int *keyPtr);	// take the first link off the
+				// list, and return its item and key
+
+  private:
+    ListLink *first;		// head of the list, NULL if empty
+    ListLink *last;		// last link on the list
+};
+
 #endif // LIST_H
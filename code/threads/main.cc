@@ -8,7 +8,9 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
+// Usage: nachos -d <debugflags> -rs <random seed #> -sched <policy>
+//		-pool <high water> -cpus <number of CPUs> -acct [file.csv]
+//		-slice fixed|adaptive -lockprof -deadlock
 //		-s -x <nachos file> -c <consoleIn> <consoleOut>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
@@ -18,6 +20,20 @@
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -sched selects the scheduling policy: fifo (default), prio,
+//		mlfq, cfs, stride or lottery
+//    -cpus simulates a multiprocessor with that many CPUs (default 1)
+//    -acct prints how each thread spent its time when Nachos halts,
+//		and writes the same table to "file.csv", if given
+//    -slice selects fixed time slices (default), or adaptive ones
+//		that grow for threads that use them up, and shrink for
+//		threads that block early
+//    -pool sets how many freed thread control blocks and stacks are
+//		kept for re-use (default 32)
+//    -lockprof prints how contended each lock, semaphore and 
+//		condition variable was, when Nachos halts
+//    -deadlock reports threads that deadlock waiting for each other's
+//		locks (see deadlock.h)
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
@@ -0,0 +1,381 @@
+// rbtree.cc
+//	Routines to manage a red-black tree of "things", sorted by key.
+//
+//	The tree routines follow the usual textbook algorithm, with NULL
+//	standing in for the black leaves.  No memory is allocated: each
+//	object on a tree carries its own RBNode.
+//
+//	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "rbtree.h"
+
+//----------------------------------------------------------------------
+// RBNode::RBNode
+// 	Initialize a tree node, so it can be put on a tree.
+//----------------------------------------------------------------------
+
+RBNode::RBNode()
+{
+    key = 0;
+    item = NULL;
+    left = right = parent = NULL;
+    red = FALSE;
+    onTree = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RBTree::RBTree
+//	Initialize a tree, empty to start with.
+//----------------------------------------------------------------------
+
+RBTree::RBTree()
+{
+    root = leftmost = NULL;
+}
+
+//----------------------------------------------------------------------
+// RBTree::~RBTree
+//	Prepare a tree for deallocation.  The nodes belong to the objects
+//	they are embedded in, so there is nothing to free; we just mark
+//	any remaining nodes as being off the tree.
+//----------------------------------------------------------------------
+
+RBTree::~RBTree()
+{
+    while (root != NULL)
+	Remove(root);
+}
+
+//----------------------------------------------------------------------
+// RBTree::RotateLeft, RBTree::RotateRight
+//	Rotate the subtree rooted at "x", keeping the in-order sequence
+//	of the nodes the same.
+//----------------------------------------------------------------------
+
+void
+RBTree::RotateLeft(RBNode *x)
+{
+    RBNode *y = x->right;
+
+    x->right = y->left;
+    if (y->left != NULL)
+	y->left->parent = x;
+    y->parent = x->parent;
+    if (x->parent == NULL)
+	root = y;
+    else if (x == x->parent->left)
+	x->parent->left = y;
+    else
+	x->parent->right = y;
+    y->left = x;
+    x->parent = y;
+}
+
+void
+RBTree::RotateRight(RBNode *x)
+{
+    RBNode *y = x->left;
+
+    x->left = y->right;
+    if (y->right != NULL)
+	y->right->parent = x;
+    y->parent = x->parent;
+    if (x->parent == NULL)
+	root = y;
+    else if (x == x->parent->right)
+	x->parent->right = y;
+    else
+	x->parent->left = y;
+    y->right = x;
+    x->parent = y;
+}
+
+//----------------------------------------------------------------------
+// RBTree::Insert
+//	Put a node on the tree, in order by its key.  A node whose key
+//	equals that of nodes already on the tree goes after them.
+//
+//	"node" is the node to insert; it must not be on any tree.
+//----------------------------------------------------------------------
+
+void
+RBTree::Insert(RBNode *node)
+{
+    RBNode *parent = NULL;
+    RBNode *ptr = root;
+    bool isLeftmost = TRUE;
+
+    ASSERT(!node->onTree);
+    while (ptr != NULL) {		// find the leaf to hang it off
+	parent = ptr;
+	if (node->key < ptr->key)
+	    ptr = ptr->left;
+	else {
+	    ptr = ptr->right;
+	    isLeftmost = FALSE;
+	}
+    }
+    node->parent = parent;
+    node->left = node->right = NULL;
+    node->red = TRUE;
+    node->onTree = TRUE;
+    if (parent == NULL)
+	root = node;
+    else if (node->key < parent->key)
+	parent->left = node;
+    else
+	parent->right = node;
+    if (isLeftmost)
+	leftmost = node;
+    InsertFixup(node);
+}
+
+//----------------------------------------------------------------------
+// RBTree::InsertFixup
+//	A red node has just been added; recolor and rotate on the way up
+//	so that no red node has a red parent.
+//----------------------------------------------------------------------
+
+void
+RBTree::InsertFixup(RBNode *z)
+{
+    while (z->parent != NULL && z->parent->red) {
+	RBNode *grand = z->parent->parent;
+
+	if (z->parent == grand->left) {
+	    RBNode *uncle = grand->right;
+
+	    if (uncle != NULL && uncle->red) {
+		z->parent->red = FALSE;
+		uncle->red = FALSE;
+		grand->red = TRUE;
+		z = grand;
+	    } else {
+		if (z == z->parent->right) {
+		    z = z->parent;
+		    RotateLeft(z);
+		}
+		z->parent->red = FALSE;
+		grand->red = TRUE;
+		RotateRight(grand);
+	    }
+	} else {
+	    RBNode *uncle = grand->left;
+
+	    if (uncle != NULL && uncle->red) {
+		z->parent->red = FALSE;
+		uncle->red = FALSE;
+		grand->red = TRUE;
+		z = grand;
+	    } else {
+		if (z == z->parent->left) {
+		    z = z->parent;
+		    RotateRight(z);
+		}
+		z->parent->red = FALSE;
+		grand->red = TRUE;
+		RotateLeft(grand);
+	    }
+	}
+    }
+    root->red = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RBTree::Transplant
+//	Replace the subtree rooted at "u" by the one rooted at "v".
+//----------------------------------------------------------------------
+
+void
+RBTree::Transplant(RBNode *u, RBNode *v)
+{
+    if (u->parent == NULL)
+	root = v;
+    else if (u == u->parent->left)
+	u->parent->left = v;
+    else
+	u->parent->right = v;
+    if (v != NULL)
+	v->parent = u->parent;
+}
+
+//----------------------------------------------------------------------
+// RBTree::Remove
+//	Take a node off the tree.
+//
+//	"node" is the node to remove; it must be on this tree.
+//----------------------------------------------------------------------
+
+void
+RBTree::Remove(RBNode *node)
+{
+    RBNode *x, *xParent;
+    bool removedRed = node->red;
+
+    ASSERT(node->onTree);
+    if (node == leftmost) {		// the next smallest is either the
+	if (node->right != NULL) {	// leftmost node of our right
+	    leftmost = node->right;	// subtree, or our parent
+	    while (leftmost->left != NULL)
+		leftmost = leftmost->left;
+	} else
+	    leftmost = node->parent;
+    }
+
+    if (node->left == NULL) {
+	x = node->right;
+	xParent = node->parent;
+	Transplant(node, node->right);
+    } else if (node->right == NULL) {
+	x = node->left;
+	xParent = node->parent;
+	Transplant(node, node->left);
+    } else {				// two children: splice in the
+	RBNode *y = node->right;	// next node in order
+
+	while (y->left != NULL)
+	    y = y->left;
+	removedRed = y->red;
+	x = y->right;
+	if (y->parent == node)
+	    xParent = y;
+	else {
+	    xParent = y->parent;
+	    Transplant(y, y->right);
+	    y->right = node->right;
+	    y->right->parent = y;
+	}
+	Transplant(node, y);
+	y->left = node->left;
+	y->left->parent = y;
+	y->red = node->red;
+    }
+    if (!removedRed)
+	RemoveFixup(x, xParent);
+
+    node->left = node->right = node->parent = NULL;
+    node->onTree = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RBTree::RemoveFixup
+//	A black node has just been taken out from above "x"; push the
+//	missing black up the tree until the black heights match again.
+//
+//	"xParent" is needed because "x" may be NULL.
+//----------------------------------------------------------------------
+
+void
+RBTree::RemoveFixup(RBNode *x, RBNode *xParent)
+{
+    while (x != root && (x == NULL || !x->red)) {
+	if (x == xParent->left) {
+	    RBNode *w = xParent->right;
+
+	    if (w->red) {
+		w->red = FALSE;
+		xParent->red = TRUE;
+		RotateLeft(xParent);
+		w = xParent->right;
+	    }
+	    if ((w->left == NULL || !w->left->red) &&
+		    (w->right == NULL || !w->right->red)) {
+		w->red = TRUE;
+		x = xParent;
+		xParent = x->parent;
+	    } else {
+		if (w->right == NULL || !w->right->red) {
+		    w->left->red = FALSE;
+		    w->red = TRUE;
+		    RotateRight(w);
+		    w = xParent->right;
+		}
+		w->red = xParent->red;
+		xParent->red = FALSE;
+		if (w->right != NULL)
+		    w->right->red = FALSE;
+		RotateLeft(xParent);
+		x = root;
+	    }
+	} else {
+	    RBNode *w = xParent->left;
+
+	    if (w->red) {
+		w->red = FALSE;
+		xParent->red = TRUE;
+		RotateRight(xParent);
+		w = xParent->left;
+	    }
+	    if ((w->right == NULL || !w->right->red) &&
+		    (w->left == NULL || !w->left->red)) {
+		w->red = TRUE;
+		x = xParent;
+		xParent = x->parent;
+	    } else {
+		if (w->left == NULL || !w->left->red) {
+		    w->right->red = FALSE;
+		    w->red = TRUE;
+		    RotateLeft(w);
+		    w = xParent->left;
+		}
+		w->red = xParent->red;
+		xParent->red = FALSE;
+		if (w->left != NULL)
+		    w->left->red = FALSE;
+		RotateRight(xParent);
+		x = root;
+	    }
+	}
+    }
+    if (x != NULL)
+	x->red = FALSE;
+}
+
+//----------------------------------------------------------------------
+// RBTree::Next
+//	Return the node that follows "node" in key order, so callers can
+//	walk the tree starting from Min().  Returns NULL at the end.
+//----------------------------------------------------------------------
+
+RBNode *
+RBTree::Next(RBNode *node)
+{
+    if (node->right != NULL) {		// leftmost node of right subtree
+	node = node->right;
+	while (node->left != NULL)
+	    node = node->left;
+	return node;
+    }
+    while (node->parent != NULL && node == node->parent->right)
+	node = node->parent;		// climb until we come up from 
+    return node->parent;		// a left child
+}
+
+//----------------------------------------------------------------------
+// RBTree::Mapcar
+//	Apply a function to the item of every node on the tree, smallest
+//	key first.
+//
+//	"func" is the procedure to apply.
+//----------------------------------------------------------------------
+
+void
+RBTree::Mapcar(VoidFunctionPtr func)
+{
+    MapcarNode(root, func);
+}
+
+void
+RBTree::MapcarNode(RBNode *node, VoidFunctionPtr func)
+{
+    if (node == NULL)
+	return;
+    MapcarNode(node->left, func);
+    (*func)((int)node->item);
+    MapcarNode(node->right, func);
+}
@@ -0,0 +1,76 @@
+// rbtree.h
+//	Data structures to manage a red-black tree -- a balanced binary
+//	search tree, kept in increasing order by an integer key.  Keys 
+//	are 64 bits wide, so that a key that only ever grows (a thread's
+//	virtual runtime, say) can't wrap around in any simulation.
+//
+//	Like List, the tree can hold any kind of item, but unlike List,
+//	the tree does not allocate anything: the caller embeds an RBNode
+//	in each object it wants to keep on a tree (a thread control
+//	block, for instance), and hands that node to Insert and Remove.
+//	An object can therefore be on at most one tree per RBNode it has.
+//
+//	Insert and Remove take O(log n) time.  The leftmost (smallest)
+//	node is cached, so Min takes constant time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines a node in a red-black tree.  The
+// fields are public so the tree routines can get at them directly;
+// users should only set "key" and "item", and only while the node is
+// not on a tree.
+
+class RBNode {
+  public:
+    RBNode();			// initialize a node, not on any tree
+
+    long long key;		// the tree is sorted by this
+    void *item;			// the object this node is embedded in
+
+    RBNode *left;		// children and parent, NULL if none
+    RBNode *right;
+    RBNode *parent;
+    bool red;			// color of the node
+    bool onTree;		// TRUE while the node is on a tree
+};
+
+// The following class defines a red-black tree of RBNodes.  Nodes
+// with equal keys are kept in the order they were inserted.
+
+class RBTree {
+  public:
+    RBTree();			// initialize the tree, empty to start with
+    ~RBTree();			// de-allocate the tree (not the nodes!)
+
+    void Insert(RBNode *node);	// put node on the tree, ordered by key
+    void Remove(RBNode *node);	// take node off the tree
+    RBNode *Min() { return leftmost; } // node with the smallest key,
+				// or NULL if the tree is empty
+    bool IsEmpty() { return (root == NULL); }
+    RBNode *Next(RBNode *node);	// the node after "node" in key order,
+				// or NULL if "node" is the last one
+
+    void Mapcar(VoidFunctionPtr func);	// apply "func" to the item of
+					// every node, in increasing order
+
+  private:
+    RBNode *root;		// top of the tree, NULL if empty
+    RBNode *leftmost;		// cached smallest node
+
+    void RotateLeft(RBNode *x);	// local restructuring, used to keep
+    void RotateRight(RBNode *x);// the tree balanced
+    void InsertFixup(RBNode *z);// restore the red-black properties
+    void RemoveFixup(RBNode *x, RBNode *xParent); // after a change
+    void Transplant(RBNode *u, RBNode *v); // replace subtree u by v
+    void MapcarNode(RBNode *node, VoidFunctionPtr func);
+};
+
+#endif // RBTREE_H
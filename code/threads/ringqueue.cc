@@ -0,0 +1,177 @@
+// ringqueue.cc
+//	Routines for a bounded queue of items, with no lock on the
+//	common path.  See ringqueue.h for why that is safe.
+//
+//	A thread only disables interrupts to go to sleep, after checking
+//	again, with interrupts off, that it really has to; or to wake up
+//	threads that went to sleep.  So no wake-up can be lost: either the
+//	item (or the room) was already there when the sleeper checked, or
+//	the sleeper was already on the list of waiters when it was added.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "ringqueue.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// RingQueue::RingQueue
+// 	Initialize an empty queue.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"slots" is how many items the queue can hold; a power of two.
+//----------------------------------------------------------------------
+
+RingQueue::RingQueue(char *debugName, int slots)
+{
+    ASSERT(slots > 0 && (slots & (slots - 1)) == 0);
+    name = debugName;
+    size = slots;
+    items = new void *[size];
+    head = tail = 0;
+    takers = new LinkList;
+    givers = new LinkList;
+}
+
+//----------------------------------------------------------------------
+// RingQueue::~RingQueue
+// 	De-allocate the queue.  Any items still on it are forgotten.
+//----------------------------------------------------------------------
+
+RingQueue::~RingQueue()
+{
+    ASSERT(takers->IsEmpty() && givers->IsEmpty());
+    delete [] items;
+    delete takers;
+    delete givers;
+}
+
+//----------------------------------------------------------------------
+// RingQueue::TryAppend
+// 	Add an item at the end of the queue, if there is room, and wake
+//	up as many waiting consumers as there are items for.
+//
+// Returns:
+//	FALSE if the queue was full, and nothing was added.
+//
+//	"item" is the thing to put on the queue; it must not be NULL.
+//----------------------------------------------------------------------
+
+bool
+RingQueue::TryAppend(void *item)
+{
+    ASSERT(item != NULL);
+    if (IsFull())
+	return FALSE;
+    items[tail & (size - 1)] = item;
+    tail++;
+    if (!takers->IsEmpty())
+	WakeUp(takers, NumItems());
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// RingQueue::TryRemove
+// 	Take the item at the front of the queue, if there is one, and 
+//	wake up as many waiting producers as there is room for.
+//
+// Returns:
+//	The item, or NULL if the queue was empty.
+//----------------------------------------------------------------------
+
+void *
+RingQueue::TryRemove()
+{
+    void *item;
+
+    if (IsEmpty())
+	return NULL;
+    item = items[head & (size - 1)];
+    head++;
+    if (!givers->IsEmpty())
+	WakeUp(givers, size - NumItems());
+    return item;
+}
+
+//----------------------------------------------------------------------
+// RingQueue::Append
+// 	Add an item at the end of the queue, waiting for room if the 
+//	queue is full.  A producer that is woken up may find the room 
+//	taken again by someone who got there first, and wait some more.
+//
+//	"item" is the thing to put on the queue; it must not be NULL.
+//----------------------------------------------------------------------
+
+void
+RingQueue::Append(void *item)
+{
+    while (!TryAppend(item)) {
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	if (IsFull())			// still full, now that no one
+	    Wait(givers);		// can get in: go to sleep
+	(void) interrupt->SetLevel(oldLevel);
+    }
+}
+
+//----------------------------------------------------------------------
+// RingQueue::Remove
+// 	Take the item at the front of the queue, waiting for one if the
+//	queue is empty.
+//
+// Returns:
+//	The item.
+//----------------------------------------------------------------------
+
+void *
+RingQueue::Remove()
+{
+    void *item;
+
+    while ((item = TryRemove()) == NULL) {
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	if (IsEmpty())			// still empty, now that no one
+	    Wait(takers);		// can get in: go to sleep
+	(void) interrupt->SetLevel(oldLevel);
+    }
+    return item;
+}
+
+//----------------------------------------------------------------------
+// RingQueue::Wait
+// 	Put the current thread to sleep on a list of waiters, until a 
+//	WakeUp.  Called with interrupts off.
+//
+//	"waiters" is the list to wait on.
+//----------------------------------------------------------------------
+
+void
+RingQueue::Wait(LinkList *waiters)
+{
+    waiters->Append(&currentThread->listLink);
+    currentThread->acct.Blocking(name);
+    currentThread->Sleep();
+}
+
+//----------------------------------------------------------------------
+// RingQueue::WakeUp
+// 	Wake up the first few threads on a list of waiters, all in one
+//	go.
+//
+//	"waiters" is the list to wake threads on.
+//	"n" is how many to wake, at most.
+//----------------------------------------------------------------------
+
+void
+RingQueue::WakeUp(LinkList *waiters, int n)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *thread;
+
+    while (n-- > 0 && (thread = (Thread *)waiters->Remove()) != NULL)
+	scheduler->ReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
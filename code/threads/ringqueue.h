@@ -0,0 +1,74 @@
+// ringqueue.h
+//	Data structures for a bounded queue of items, shared by any
+//	number of producers and consumers, that needs no lock.
+//
+//	Like SynchList, Remove waits while the queue is empty; since the
+//	queue is bounded, Append also waits while it is full.  Unlike
+//	SynchList, taking or adding an item never touches a Lock or the
+//	interrupt level, unless the thread has to wait, or there is a
+//	thread waiting to be woken up.  Enabling interrupts advances the
+//	simulated time, so the common case costs no time at all, where
+//	SynchList costs several ticks per item.
+//
+//	The items live in a circular array indexed by two counters that
+//	only ever increase.  As in WorkDeque, no compare-and-swap is
+//	needed to claim a slot: threads only change turns when interrupts
+//	are re-enabled, or one goes to sleep, so nothing can come between
+//	a thread checking a counter and moving it.  This holds on the
+//	simulated multiprocessor too, since only one host thread runs at
+//	a time.
+//
+//	Wake-ups are batched: a thread that adds an item to a queue with
+//	consumers waiting wakes up as many of them as there are items to
+//	take, all with interrupts off once, and likewise for producers
+//	waiting for room.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef RINGQUEUE_H
+#define RINGQUEUE_H
+
+#include "copyright.h"
+#include "list.h"
+
+// The following class defines a bounded multi-producer, multi-consumer
+// queue.  Items must not be NULL.
+
+class RingQueue {
+  public:
+    RingQueue(char *debugName, int slots);	// initialize an empty
+					// queue with room for "slots" items,
+					// a power of two
+    ~RingQueue();			// de-allocate the queue; no one
+					// may be waiting on it
+
+    bool TryAppend(void *item);		// add an item at the end; FALSE
+					// if the queue is full
+    void *TryRemove();			// take the item at the front;
+					// NULL if the queue is empty
+    void Append(void *item);		// add an item, waiting while the
+					// queue is full
+    void *Remove();			// take an item, waiting while the
+					// queue is empty
+
+    char *getName() { return name; }
+    bool IsEmpty() { return (head == tail); }
+    bool IsFull() { return (tail - head == (unsigned)size); }
+    int NumItems() { return (int)(tail - head); }
+
+  private:
+    char *name;				// for debugging
+    void **items;			// circular array of items
+    int size;				// number of slots
+    unsigned int head;			// index of the oldest item
+    unsigned int tail;			// index one past the newest item
+    LinkList *takers;			// threads waiting in Remove
+    LinkList *givers;			// threads waiting in Append
+
+    void Wait(LinkList *waiters);	// sleep on "waiters" until woken
+    void WakeUp(LinkList *waiters, int n);	// wake up to "n" waiters
+};
+
+#endif // RINGQUEUE_H
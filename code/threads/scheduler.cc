@@ -11,8 +11,15 @@
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	Six disciplines are supported: straight FIFO, preemptive
+//	priority, a multi-level feedback queue (MLFQ) that keeps
+//	one FIFO per priority level, and a completely fair scheduler
+//	(CFS), plus stride and lottery proportional share scheduling.
+//	The priority disciplines use a ReadyQueue, which keeps a bitmap
+//	of the non-empty levels, so finding the highest priority ready
+//	thread never has to walk a list.  CFS and stride keep the ready
+//	threads on a red-black tree ordered by virtual runtime (or 
+//	pass, which is the same thing with tickets for weights).
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -22,14 +29,206 @@
 #include "scheduler.h"
 #include "system.h"
 
+#include <string.h>		// for strcmp
+#include <strings.h>		// for ffs
+
+// How much virtual runtime a thread of each priority accrues per tick
+// (65536 / weight).  The weights are Linux's for nice -8 to 7: each 
+// priority level gets about 1.25 times the CPU of the next one down.
+static int vruntimePerTick[NumPrioLevels] = {
+     11,  13,  17,  21,  26,  33,  41,  51,
+     64,  80, 100, 125, 155, 196, 241, 305
+};
+
+// The CPU share of the threads that have finished, kept for 
+// PrintShares.  Threads with the same name and tickets share a record,
+// and once there are MaxShareRecords records, the threads that don't
+// fit one are lumped together in "otherShares", so the log stays the
+// same size however many threads come and go.
+class ShareRecord {
+  public:
+    ShareRecord(char *n, int t, double e, int r, int k = 1) 
+	{ name = n; tickets = t; entitled = e; ran = r; threads = k; }
+    char *name;
+    int tickets;		// tickets each thread held
+    double entitled;		// ticks their tickets entitled them to
+    int ran;			// ticks they actually got
+    int threads;		// how many threads this covers
+};
+
+#define MaxShareRecords	32
+
+static ShareRecord *shareLog[MaxShareRecords];
+static int numShareRecords;
+static ShareRecord otherShares("(other threads)", 0, 0.0, 0, 0);
+
+// The share clock, for the proportional share statistics: how much 
+// CPU time each ticket held by a contending (ready or running) thread
+// has been entitled to so far.  A thread that contends while the clock
+// goes from a to b is entitled to (b - a) ticks per ticket it holds, so
+// it is only compared with the threads it actually competed with.  The
+// clock is shared by all the CPUs; no thread can use more than one.
+static double shareClock;
+static int shareClockAt;		// when it was last brought up to date
+static int contendingTickets;		// tickets held by contending threads
+static int numContending;		// number of contending threads
+
+static void
+AdvanceShareClock()
+{
+    int now = stats->totalTicks;
+    int cpus = min(cpuSet->NumCpus(), numContending);
+
+    if (contendingTickets > 0)
+	shareClock += (double)(now - shareClockAt) * cpus / contendingTickets;
+    shareClockAt = now;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::ReadyQueue
+// 	Initialize a priority ready queue, with every bucket empty.
+//----------------------------------------------------------------------
+
+ReadyQueue::ReadyQueue()
+{
+    for (int i = 0; i < NumPrioLevels; i++)
+	head[i] = tail[i] = NULL;
+    mask = 0;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::Append
+// 	Put a thread at the end of the bucket for its current priority.
+//
+//	"thread" is the thread to queue; it must not be on any other
+//		ready queue.
+//----------------------------------------------------------------------
+
+void
+ReadyQueue::Append(Thread *thread)
+{
+    int prio = thread->getPrio();
+
+    ASSERT((prio >= 0) && (prio < NumPrioLevels));
+    thread->readyNext = NULL;
+    if (head[prio] == NULL) {
+	head[prio] = thread;
+	mask |= (1 << prio);
+    } else
+	tail[prio]->readyNext = thread;
+    tail[prio] = thread;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::Remove
+// 	Take the first thread off the highest priority non-empty bucket.
+//
+// Returns:
+//	The thread, or NULL if the queue is empty.
+//----------------------------------------------------------------------
+
+Thread *
+ReadyQueue::Remove()
+{
+    if (mask == 0)
+	return NULL;
+
+    int prio = ffs(mask) - 1;		// lowest set bit = highest priority
+    Thread *thread = head[prio];
+
+    head[prio] = thread->readyNext;
+    if (head[prio] == NULL) {
+	tail[prio] = NULL;
+	mask &= ~(1 << prio);
+    }
+    thread->readyNext = NULL;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::Unlink
+// 	Take a particular thread off the queue, wherever it is.  Every
+//	bucket is searched, since the thread's priority may have been
+//	changed (by an MLFQ boost) since it was queued.
+//
+// Returns:
+//	TRUE if the thread was on the queue.
+//
+//	"thread" is the thread to take off.
+//----------------------------------------------------------------------
+
+bool
+ReadyQueue::Unlink(Thread *thread)
+{
+    for (int i = 0; i < NumPrioLevels; i++) {
+	Thread *prev = NULL;
+
+	for (Thread *t = head[i]; t != NULL; prev = t, t = t->readyNext) {
+	    if (t != thread)
+		continue;
+	    if (prev == NULL)
+		head[i] = t->readyNext;
+	    else
+		prev->readyNext = t->readyNext;
+	    if (tail[i] == t)
+		tail[i] = prev;
+	    if (head[i] == NULL)
+		mask &= ~(1 << i);
+	    t->readyNext = NULL;
+	    return TRUE;
+	}
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::HighestPrio
+// 	Return the priority of the most important ready thread, or
+//	NumPrioLevels if there is no ready thread.
+//----------------------------------------------------------------------
+
+int
+ReadyQueue::HighestPrio()
+{
+    if (mask == 0)
+	return NumPrioLevels;
+    return ffs(mask) - 1;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::Mapcar
+// 	Apply a function to every thread on the queue, highest priority
+//	first, in FIFO order within a bucket.
+//
+//	"func" is the procedure to apply to each thread.
+//----------------------------------------------------------------------
+
+void
+ReadyQueue::Mapcar(VoidFunctionPtr func)
+{
+    for (int i = 0; i < NumPrioLevels; i++)
+	for (Thread *t = head[i]; t != NULL; t = t->readyNext)
+	    (*func)((int)t);
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
 // 	Initialize the list of ready but not running threads to empty.
+//
+//	"p" is the scheduling discipline to use.
+//	"s" is the time slice policy.
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(SchedPolicy p, SlicePolicy s)
 { 
-    readyList = new List; 
+    policy = p;
+    slicePolicy = s;
+    sliceLonger = sliceShorter = 0;
+    readyList = new LinkList; 
+    prioQueue = new ReadyQueue;
+    lastBoost = 0;
+    runTree = new RBTree;
+    minVruntime = 0;
 } 
 
 //----------------------------------------------------------------------
@@ -40,6 +239,8 @@ Scheduler::Scheduler()
 Scheduler::~Scheduler()
 { 
     delete readyList; 
+    delete prioQueue;
+    delete runTree;
 } 
 
 //----------------------------------------------------------------------
@@ -54,14 +255,141 @@ void
 Scheduler::ReadyToRun (Thread *thread)
 {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
+    StartContending(thread);
 
+    if (UsesRunTree()) {
+	int credit = (policy == SCHED_CFS) ? CFSSleeperCredit : 0;
+
+	if (thread == currentThread)		// yielding: bring its 
+	    Charge(thread);			// vruntime up to date
+	else if (thread->getStatus() == JUST_CREATED)
+	    thread->vruntime = max(thread->vruntime, minVruntime);
+	else 					// waking up: don't let it
+	    thread->vruntime = max(thread->vruntime, // hog the CPU to
+			minVruntime - credit);	    // catch up
+    }
     thread->setStatus(READY);
-    /* priority
-    readyList->SortedInsert((void *)thread,thread->getPrio());
-    if(thread->getPrio()<currentThread->getPrio())
-        currentThread->Yield();
-        */
-    readyList->Append((void*)thread);
+    if (policy == SCHED_FIFO)
+	readyList->Append(&thread->listLink);
+    else if (UsesRunTree()) {
+	thread->treeNode.key = thread->vruntime;
+	runTree->Insert(&thread->treeNode);
+    } else
+	prioQueue->Append(thread);
+    if (policy != SCHED_FIFO && CheckPreempt(thread, currentThread))
+	SwitchSoon();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::CheckPreempt
+// 	Decide whether a thread that was just made ready is more 
+//	important than the thread running on our CPU, so that the 
+//	running thread should be switched out.  We never switch here: 
+//	our callers (Semaphore::V, for one) are in the middle of 
+//	updating their own state.  On the current CPU, they call 
+//	SwitchSoon; another CPU switches at the start of its next turn.
+//
+//	Under SCHED_CFS, "more important" means having run for less 
+//	virtual time, by a margin of CFSWakeupGran.
+//
+// Returns:
+//	TRUE if "running" should give up the CPU to "thread".
+//
+//	"thread" is the thread that was just put on the ready queue.
+//	"running" is the thread running on our CPU, or NULL if it is
+//		idle.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::CheckPreempt(Thread *thread, Thread *running)
+{
+    if (running == NULL || thread == running
+	    || running->getStatus() != RUNNING
+	    || policy == SCHED_STRIDE || policy == SCHED_LOTTERY)
+	return FALSE;
+    if (policy == SCHED_CFS) {
+	Charge(running);
+	if (thread->vruntime + CFSWakeupGran >= running->vruntime)
+	    return FALSE;
+    } else if (thread->getPrio() >= running->getPrio())
+	return FALSE;
+
+    DEBUG('t', "Thread \"%s\" preempts thread \"%s\"\n", 
+	  thread->getName(), running->getName());
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SwitchSoon
+// 	Arrange for the running thread to be switched out: on return 
+//	from the interrupt handler if we are in one (YieldOnReturn), 
+//	otherwise the next time interrupts are re-enabled 
+//	(YieldOnNextTick), so a high priority thread waits at most one
+//	tick, rather than a whole time slice, to get the CPU.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SwitchSoon()
+{
+    if (interrupt->InHandler())
+	interrupt->YieldOnReturn();
+    else
+	interrupt->YieldOnNextTick();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ChangePrio
+// 	Change a thread's priority (for priority inheritance, see 
+//	Lock::Acquire), keeping the ready queue in order.  A ready thread
+//	is moved to the bucket for its new priority; it is up to the 
+//	caller to check whether it should now preempt our CPU's thread 
+//	(see CpuSet::ChangePrio).  The running thread is switched out if
+//	it is no longer the most important.  Under the other policies, nothing 
+//	has to move; CFS only has to bill the running thread at its old
+//	weight first.
+//
+// Returns:
+//	TRUE if the priority was changed: "thread" was running on this 
+//	CPU, or on our ready queue.
+//
+//	"thread" is the thread whose priority changes.
+//	"prio" is its new priority.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::ChangePrio(Thread *thread, int prio)
+{
+    bool queued = (policy == SCHED_PRIO || policy == SCHED_MLFQ);
+
+    if (thread == currentThread) {
+	if (policy == SCHED_CFS && thread->getStatus() == RUNNING)
+	    Charge(thread);
+	thread->setPrio(prio);
+	if (queued && prioQueue->HasHigherThan(prio))
+	    SwitchSoon();
+	return TRUE;
+    }
+    if (!queued || thread->getStatus() != READY 
+	    || !prioQueue->Unlink(thread))
+	return FALSE;
+    thread->setPrio(prio);
+    prioQueue->Append(thread);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::IsEmpty
+// 	Return TRUE if there are no threads on the ready list.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::IsEmpty()
+{
+    if (UsesRunTree())
+	return runTree->IsEmpty();
+    if (policy != SCHED_FIFO)
+	return prioQueue->IsEmpty();
+    return readyList->IsEmpty();
 }
 
 //----------------------------------------------------------------------
@@ -70,14 +398,201 @@ Scheduler::ReadyToRun (Thread *thread)
 //	If there are no ready threads, return NULL.
 // Side effect:
 //	Thread is removed from the ready list.
+//
+//	"running" is the thread running on our CPU, if any, which still
+//		counts towards minVruntime.
 //----------------------------------------------------------------------
 
 Thread *
-Scheduler::FindNextToRun ()
+Scheduler::FindNextToRun (Thread *running)
 {
+    if (UsesRunTree()) {
+	RBNode *node;
+
+	if (policy == SCHED_LOTTERY)
+	    node = DrawLottery();
+	else
+	    node = runTree->Min();
+	if (node == NULL)
+	    return NULL;
+	runTree->Remove(node);
+	UpdateMinVruntime(running);
+	return (Thread *)node->item;
+    }
+    if (policy != SCHED_FIFO)
+	return prioQueue->Remove();
     return (Thread *)readyList->Remove();
 }
 
+//----------------------------------------------------------------------
+// Scheduler::DrawLottery
+// 	Hold a lottery among the ready threads: each thread's chance of
+//	winning is its share of the tickets held by all ready threads.
+//
+// Returns:
+//	The winner's tree node, still on the tree, or NULL if no thread
+//	is ready.
+//----------------------------------------------------------------------
+
+RBNode *
+Scheduler::DrawLottery()
+{
+    RBNode *node;
+    int total = 0;
+    int winner;
+
+    for (node = runTree->Min(); node != NULL; node = runTree->Next(node))
+	total += ((Thread *)node->item)->getTickets();
+    if (total == 0)
+	return NULL;
+
+    winner = Random() % total;
+    for (node = runTree->Min(); node != NULL; node = runTree->Next(node)) {
+	winner -= ((Thread *)node->item)->getTickets();
+	if (winner < 0)
+	    break;
+    }
+    return node;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Add the CPU time a thread has used since it was last charged to 
+//	its virtual runtime, scaled by the weight of its priority (CFS)
+//	or by its tickets (stride and lottery).
+//
+//	"thread" is the running thread.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Charge(Thread *thread)
+{
+    int now = stats->totalTicks;
+    long long units;
+
+    if (policy == SCHED_CFS)
+	thread->vruntime += (long long)(now - thread->chargedAt) 
+				* vruntimePerTick[thread->getPrio()];
+    else {				// carry what doesn't divide
+	units = (long long)(now - thread->chargedAt) * StrideOne 
+				+ thread->passLeft;
+	thread->vruntime += units / thread->getTickets();
+	thread->passLeft = (int)(units % thread->getTickets());
+    }
+    thread->chargedAt = now;
+    UpdateMinVruntime(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::UpdateMinVruntime
+// 	Advance minVruntime to the least virtual runtime of the running
+//	thread and the ready threads.  It is never moved backwards, so 
+//	that a thread that slept for a long time cannot drag it down.
+//
+//	"running" is the thread running on our CPU -- which, with more 
+//		than one CPU, need not be currentThread -- or NULL.
+//----------------------------------------------------------------------
+
+void
+Scheduler::UpdateMinVruntime(Thread *running)
+{
+    RBNode *node = runTree->Min();
+    long long least;
+
+    if (running != NULL && running->getStatus() == RUNNING) {
+	least = running->vruntime;
+	if (node != NULL)
+	    least = min(least, node->key);
+    } else if (node != NULL)
+	least = node->key;
+    else
+	return;
+    minVruntime = max(minVruntime, least);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::TimerTick
+// 	Called by the timer interrupt handler, with interrupts disabled,
+//	on behalf of the running thread.  Decide whether the thread has
+//	used up its time slice.
+//
+//	Under SCHED_MLFQ, a thread that burns its whole slice is demoted
+//	one level, and every BoostInterval ticks all threads are moved
+//	back to their base level so that nothing starves.
+//
+//	Under SLICE_ADAPTIVE, a thread that burns its whole slice gets 
+//	twice as long next time.
+//
+// Returns:
+//	TRUE if the thread should be switched out.
+//
+//	"thread" is the running thread.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::TimerTick(Thread *thread)
+{
+    if (policy == SCHED_MLFQ && stats->totalTicks - lastBoost >= BoostInterval)
+	Boost();
+    if (UsesRunTree())
+	Charge(thread);
+
+    if (thread->getUsedtime() < thread->quantum)
+	return FALSE;
+
+    stats->numSlicesUsedUp++;
+    if (slicePolicy == SLICE_ADAPTIVE && thread->quantum < MaxTimeSlice) {
+	thread->quantum = min(2 * thread->quantum, MaxTimeSlice);
+	sliceLonger++;
+    }
+
+    if (policy == SCHED_MLFQ && thread->getPrio() < NumPrioLevels - 1) {
+	DEBUG('t', "Demoting thread \"%s\" to level %d\n", 
+	      thread->getName(), thread->getPrio() + 1);
+	thread->setPrio(thread->getPrio() + 1);
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Boost, Scheduler::Rebucket
+// 	Reset every thread in the system to its base priority, and move
+//	the threads already on the ready queues -- every CPU's, since 
+//	the threads on all of them have changed -- to their new level.
+//	A thread running above its base priority, because it holds a 
+//	lock that a more important thread wants, keeps that priority.
+//----------------------------------------------------------------------
+
+static void
+ResetPrio(int arg)
+{
+    Thread *thread = (Thread *)arg;
+
+    thread->setPrio(min(thread->getPrio(), thread->getBasePrio()));
+}
+
+void
+Scheduler::Boost()
+{
+    DEBUG('t', "Boosting all threads at time %d\n", stats->totalTicks);
+    threadTable->Mapcar(ResetPrio);
+    for (int i = 0; i < cpuSet->NumCpus(); i++)
+	cpuSet->GetCpu(i)->scheduler->Rebucket();
+}
+
+void
+Scheduler::Rebucket()
+{
+    ReadyQueue *old = prioQueue;
+    Thread *thread;
+
+    lastBoost = stats->totalTicks;		// we've had this one
+    prioQueue = new ReadyQueue;			// re-bucket, keeping the
+    while ((thread = old->Remove()) != NULL)	// FIFO order within 
+	prioQueue->Append(thread);		// each level
+    delete old;
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Run
 // 	Dispatch the CPU to nextThread.  Save the state of the old thread,
@@ -97,17 +612,33 @@ Scheduler::Run (Thread *nextThread)
 {
     Thread *oldThread = currentThread;
     
-#ifdef USER_PROGRAM			// ignore until running user programs 
-    if (currentThread->space != NULL) {	// if this thread is a user program,
-        currentThread->SaveUserState(); // save the user's CPU registers
-	currentThread->space->SaveState();
-    }
-#endif
+    // If the old thread is a user program, its user registers and 
+    // address space are left in the machine; they are only saved when
+    // the next user thread is restored (see Thread::RestoreUserState
+    // and AddrSpace::RestoreState).  Nothing is copied if the next 
+    // user thread to run is the old thread again, and the address 
+    // space is not reloaded if the next one shares it.
     
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
+    if (slicePolicy == SLICE_ADAPTIVE && oldThread->getStatus() == BLOCKED
+	    && oldThread->getUsedtime() < oldThread->quantum
+	    && oldThread->quantum > MinTimeSlice) {
+	oldThread->quantum = max(oldThread->quantum / 2, MinTimeSlice);
+	sliceShorter++;			    // it blocked before its time
+    }					    // slice was up
+    stats->numContextSwitches++;
+    interrupt->CancelYield();		    // any preemption asked for was
+					    // meant for the old thread
+    if (UsesRunTree()) {		    // bill the old thread, and
+	Charge(oldThread);		    // start the clock on the new
+	nextThread->chargedAt = stats->totalTicks;
+    }
 
     currentThread = nextThread;		    // switch to the next thread
+    currentCpu->current = nextThread;	    // (on this CPU)
+    currentCpu->needResched = FALSE;
+    currentCpu->NoteRun(nextThread);
     currentThread->setStatus(RUNNING);      // nextThread is now running
     
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
@@ -122,22 +653,54 @@ Scheduler::Run (Thread *nextThread)
     
     DEBUG('t', "Now in thread \"%s\"\n", currentThread->getName());
 
-    // If the old thread gave up the processor because it was finishing,
-    // we need to delete its carcass.  Note we cannot delete the thread
-    // before now (for example, in Thread::Finish()), because up to this
-    // point, we were still running on the old thread's stack!
-    if (threadToBeDestroyed != NULL) {
-        delete threadToBeDestroyed;
-	threadToBeDestroyed = NULL;
-    }
+    Reap();
     
 #ifdef USER_PROGRAM
     if (currentThread->space != NULL) {		// if there is an address space
-        currentThread->RestoreUserState();     // to restore, do it.
-	currentThread->space->RestoreState();
+        currentThread->RestoreUserState();     // to restore, do it (if
+	currentThread->space->RestoreState();	// it isn't still there)
     }
-    currentThread->used_time=0;
 #endif
+    currentThread->resetUsedtime();	// start a fresh time slice
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Dispatch
+// 	Get a thread taken off the ready list ready to run on an idle 
+//	CPU.  This is the part of Run that concerns the new thread; 
+//	there is no old thread to bill, since the CPU was idle.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Dispatch(Thread *thread)
+{
+    thread->setStatus(RUNNING);
+    if (UsesRunTree())
+	thread->chargedAt = stats->totalTicks;
+    thread->resetUsedtime();
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Reap
+// 	If the old thread gave up the processor because it was finishing,
+//	we need to delete its carcass.  Note we cannot delete the thread
+//	before now (for example, in Thread::Finish()), because up to this
+//	point, we were still running on the old thread's stack!
+//
+//	Called on the far side of SWITCH -- at the end of Run, or, for 
+//	a thread running for the first time, from ThreadRoot before it 
+//	calls the forked procedure.  Otherwise a thread that finishes 
+//	just before a brand new thread is switched to is never deleted, 
+//	and its thread ID is never freed.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Reap()
+{
+    if (threadToBeDestroyed != NULL) {
+        delete threadToBeDestroyed;
+	threadToBeDestroyed = NULL;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -149,6 +712,193 @@ void
 Scheduler::Print()
 {
     printf("Ready list contents:");
-    readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
+    if (UsesRunTree())
+	runTree->Mapcar((VoidFunctionPtr) ThreadPrint);
+    else if (policy != SCHED_FIFO)
+	prioQueue->Mapcar((VoidFunctionPtr) ThreadPrint);
+    else
+	readyList->Mapcar((VoidFunctionPtr) ThreadPrint);
     printf("\n");
 }
+
+
+//----------------------------------------------------------------------
+// Scheduler::StartContending, Scheduler::StopContending,
+// Scheduler::Entitled
+// 	Keep track of which threads are competing for the CPU, under the
+//	proportional share disciplines: a thread starts when it is made
+//	ready, and stops when it blocks or finishes.  While it competes,
+//	it is entitled to its tickets' worth of the share clock.  
+//	Entitled returns how much that has come to, so far.
+//
+//	"thread" is the thread starting or stopping.
+//----------------------------------------------------------------------
+
+void
+Scheduler::StartContending(Thread *thread)
+{
+    if ((policy != SCHED_STRIDE && policy != SCHED_LOTTERY) 
+	    || thread->contending)
+	return;
+    AdvanceShareClock();
+    thread->contending = TRUE;
+    thread->shareTickets = thread->getTickets();
+    thread->shareStart = shareClock;
+    contendingTickets += thread->shareTickets;
+    numContending++;
+}
+
+void
+Scheduler::StopContending(Thread *thread)
+{
+    if (!thread->contending)
+	return;
+    AdvanceShareClock();
+    thread->entitled += thread->shareTickets * (shareClock - thread->shareStart);
+    thread->contending = FALSE;
+    contendingTickets -= thread->shareTickets;
+    numContending--;
+}
+
+double
+Scheduler::Entitled(Thread *thread)
+{
+    double entitled = thread->entitled;
+
+    if (thread->contending)
+	entitled += thread->shareTickets * (shareClock - thread->shareStart);
+    return entitled;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::RecordShare
+// 	Remember how many tickets a thread that is being deleted held, 
+//	how much CPU they entitled it to, and how much it got, so 
+//	PrintShares can report on it after it is gone.  Called from the
+//	Thread destructor, whether the thread was reaped after it 
+//	finished, or deleted by Join.  Does nothing unless we are using
+//	a proportional share discipline.
+//----------------------------------------------------------------------
+
+void
+Scheduler::RecordShare(Thread *thread)
+{
+    ShareRecord *rec = &otherShares;
+    SchedPolicy p = scheduler->getPolicy();
+
+    if (p != SCHED_STRIDE && p != SCHED_LOTTERY)
+	return;
+    for (int i = 0; i < numShareRecords; i++)
+	if (shareLog[i]->tickets == thread->getTickets() 
+		&& strcmp(shareLog[i]->name, thread->getName()) == 0) {
+	    rec = shareLog[i];
+	    break;
+	}
+    if (rec == &otherShares && numShareRecords < MaxShareRecords) {
+	shareLog[numShareRecords++] = new ShareRecord(thread->getName(),
+	    thread->getTickets(), Entitled(thread), thread->getTotaltime());
+	return;
+    }
+    rec->entitled += Entitled(thread);
+    rec->ran += thread->getTotaltime();
+    rec->threads++;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::PrintStats
+// 	Print scheduler statistics at system shutdown.
+//----------------------------------------------------------------------
+
+void
+Scheduler::PrintStats()
+{
+    if (slicePolicy == SLICE_ADAPTIVE)
+	printf("Adaptive time slices: made longer %d times, shorter %d "
+	       "times\n", sliceLonger, sliceShorter);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::PrintShares
+// 	Under the proportional share disciplines, print, once for all 
+//	the CPUs, the CPU share each thread asked for (the time its 
+//	tickets entitled it to, out of the CPU time handed out, see 
+//	AdvanceShareClock) and the share it achieved (its ticks, out of 
+//	all ticks run by threads).
+//----------------------------------------------------------------------
+
+static double shareEntitled;		// totals, for PrintShare
+static int shareTicks;
+static List *liveShares;		// threads still around, for RecordLive
+
+static void
+SumShare(int arg)
+{
+    ShareRecord *rec = (ShareRecord *)arg;
+
+    shareEntitled += rec->entitled;
+    shareTicks += rec->ran;
+}
+
+static void
+RecordLive(int arg)
+{
+    Thread *thread = (Thread *)arg;
+
+    liveShares->Append((void *)new ShareRecord(thread->getName(),
+	thread->getTickets(), Scheduler::Entitled(thread), 
+	thread->getTotaltime()));
+}
+
+static void
+PrintShare(int arg)
+{
+    ShareRecord *rec = (ShareRecord *)arg;
+    char label[40];
+
+    if (rec->threads == 0)
+	return;
+    if (rec->threads == 1)
+	sprintf(label, "%.39s", rec->name);
+    else
+	sprintf(label, "%.24s (%d threads)", rec->name, rec->threads);
+    if (rec == &otherShares)
+	printf("  %-20s tickets     -", label);
+    else
+	printf("  %-20s tickets %5d", label, rec->tickets);
+    printf(", requested %5.1f%%, achieved %5.1f%%\n",
+	100.0 * rec->entitled / shareEntitled,
+	(shareTicks == 0) ? 0.0 : 100.0 * rec->ran / shareTicks);
+}
+
+void
+Scheduler::PrintShares()
+{
+    SchedPolicy p = scheduler->getPolicy();
+    int i;
+
+    if (p != SCHED_STRIDE && p != SCHED_LOTTERY)
+	return;
+
+    List *live = new List;			// threads still around
+    liveShares = live;
+    AdvanceShareClock();
+    threadTable->Mapcar(RecordLive);
+
+    shareEntitled = 0;
+    shareTicks = 0;
+    for (i = 0; i < numShareRecords; i++)
+	SumShare((int)shareLog[i]);
+    SumShare((int)&otherShares);
+    live->Mapcar(SumShare);
+    if (shareEntitled > 0) {
+	printf("Proportional share (%s):\n", 
+	       (p == SCHED_STRIDE) ? "stride" : "lottery");
+	for (i = 0; i < numShareRecords; i++)
+	    PrintShare((int)shareLog[i]);
+	PrintShare((int)&otherShares);
+	live->Mapcar(PrintShare);
+    }
+    while (!live->IsEmpty())
+	delete (ShareRecord *)live->Remove();
+    delete live;
+}
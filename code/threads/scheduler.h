@@ -11,26 +11,174 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "rbtree.h"
 #include "thread.h"
 
+// Scheduling policies.  The policy is picked once, in Initialize,
+// from the "-sched" command line flag.
+//
+//	SCHED_FIFO -- straight round robin, ignoring priorities
+//	SCHED_PRIO -- preemptive priority: the most important ready 
+//		thread always runs, round robin among equal priorities
+//	SCHED_MLFQ -- multi-level feedback queue: one ready queue per
+//		priority level, a thread that uses up its whole time
+//		slice drops one level, and every BoostInterval ticks all
+//		threads are moved back to the level they started at
+//	SCHED_CFS  -- completely fair: run the thread with the least
+//		virtual runtime, which grows more slowly for more 
+//		important threads, so each gets a CPU share in 
+//		proportion to the weight of its priority
+//	SCHED_STRIDE -- proportional share by stride scheduling: each
+//		thread holds tickets, and its "pass" advances by 
+//		StrideOne / tickets for every tick it runs; the thread 
+//		with the lowest pass runs next
+//	SCHED_LOTTERY -- proportional share by lottery: the next thread
+//		is drawn at random, weighted by tickets
+//
+// The priority disciplines and SCHED_CFS preempt the running thread as
+// soon as a more important thread becomes ready.  The proportional
+// share disciplines only switch at the end of a time slice.
+enum SchedPolicy { SCHED_FIFO, SCHED_PRIO, SCHED_MLFQ, SCHED_CFS,
+		   SCHED_STRIDE, SCHED_LOTTERY };
+
+// Time slice policies, picked with the "-slice" command line flag.
+//
+//	SLICE_FIXED -- every time slice is TimeSlice ticks long
+//	SLICE_ADAPTIVE -- each thread has a time slice of its own, which
+//		is doubled (up to MaxTimeSlice) every time the thread uses
+//		all of it, and halved (down to MinTimeSlice) every time
+//		the thread blocks before it is up.  CPU-bound threads get
+//		long slices, and so fewer context switches; threads that
+//		block early get short ones, so they can't hold up others 
+//		for long when they do compute.
+enum SlicePolicy { SLICE_FIXED, SLICE_ADAPTIVE };
+
+#define MinTimeSlice	TimerTicks	// time slices can't be shorter 
+					// than the timer's resolution
+#define MaxTimeSlice	(8 * TimeSlice)
+
+#define NumPrioLevels	16	// Thread::prio runs from 0 (highest) to 15
+#define BoostInterval	1000	// ticks between two MLFQ priority boosts
+
+// Virtual runtime is kept in units of 1/64 of a tick of a thread at 
+// the middle priority (8).  A sleeper is put back no further than 
+// CFSSleeperCredit behind the leader, and a waking thread only 
+// preempts if it is more than CFSWakeupGran behind the running one.
+// Virtual runtimes are 64 bits wide: at 305 units a tick, the lowest
+// priority would overflow an int in about seven million ticks, and 
+// then sort before every other thread and keep the CPU.
+#define CFSSleeperCredit (TimeSlice * 64)
+#define CFSWakeupGran	(TimerTicks * 64)
+
+#define StrideOne	(1 << 20)	// a thread's pass grows by StrideOne /
+				// tickets for each tick it runs; the
+				// remainder is carried, so the shares
+				// are exact
+
+// The following class defines a priority ready queue: one FIFO bucket
+// per priority level, plus a 16-bit mask of the non-empty buckets.
+// The buckets are threaded through Thread::readyNext, so no list
+// elements are allocated, and every operation but Unlink is constant 
+// time.  A Lock keeps the threads waiting for it on one as well; a 
+// blocked thread is on no ready queue, so its readyNext is free.
+
+class ReadyQueue {
+  public:
+    ReadyQueue();			// initialize to empty
+
+    void Append(Thread *thread);	// put thread at the end of the
+					// bucket for its priority
+    Thread *Remove();			// take the first thread off the
+					// highest priority non-empty bucket
+    bool Unlink(Thread *thread);	// take "thread" off the queue, 
+					// wherever it is; FALSE if it isn't
+					// there
+    bool IsEmpty() { return (mask == 0); }
+    int HighestPrio();			// best priority ready, or 
+					// NumPrioLevels if none
+    bool HasHigherThan(int prio)	// is anyone more important
+	{ return (mask & ((1 << prio) - 1)) != 0; } // than "prio" ready?
+    void Mapcar(VoidFunctionPtr func);	// apply "func" to every thread,
+					// highest priority first
+
+  private:
+    Thread *head[NumPrioLevels];	// first thread in each bucket
+    Thread *tail[NumPrioLevels];	// last thread in each bucket
+    unsigned short mask;		// bit i is set iff bucket i is
+					// non-empty
+};
+
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
 
 class Scheduler {
   public:
-    Scheduler();			// Initialize list of ready threads 
+    Scheduler(SchedPolicy p = SCHED_FIFO,	// Initialize list of ready 
+	      SlicePolicy s = SLICE_FIXED);	// threads
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
-    Thread* FindNextToRun();		// Dequeue first thread on the ready 
-					// list, if any, and return thread.
+    Thread* FindNextToRun(Thread *running);	// Dequeue first thread on 
+					// the ready list, if any, and return
+					// thread; "running" is the thread
+					// running on our CPU, or NULL
+    bool IsEmpty();			// Is the ready list empty?
+    bool ChangePrio(Thread *thread, int prio);	// Change the priority
+					// of the running thread, or of a 
+					// ready thread if it is on our list
+    bool CheckPreempt(Thread *thread, Thread *running);	// should 
+					// "thread" run instead of "running"?
+    void SwitchSoon();			// switch out the running thread
+					// as soon as it is safe to
     void Run(Thread* nextThread);	// Cause nextThread to start running
+    void Dispatch(Thread* thread);	// Thread starts running on an idle
+					// CPU, without a context switch
+    void Reap();			// Delete the thread that finished
+					// just before we switched in
+    bool TimerTick(Thread* thread);	// Called on every timer interrupt;
+					// TRUE if "thread" should give up 
+					// the CPU
     void Print();			// Print contents of ready list
+    void PrintStats();			// Print per-policy statistics, 
+					// at system shutdown
+    static void PrintShares();		// Print every thread's CPU share
+					// (proportional share only)
+    static void RecordShare(Thread *thread);	// log the share of a
+					// thread that is going away
+    void StartContending(Thread *thread);	// "thread" now wants the
+					// CPU, or
+    void StopContending(Thread *thread);	// no longer does (for the
+					// proportional share statistics)
+    static double Entitled(Thread *thread);	// CPU time its tickets
+					// have entitled it to, up to now
+    SchedPolicy getPolicy() { return policy; }
     
   private:
-    List *readyList;  		// queue of threads that are ready to run,
-				// but not running
+    SchedPolicy policy;		// which scheduling discipline to use
+    SlicePolicy slicePolicy;	// how long time slices are
+    int sliceLonger;		// number of times a thread's time slice
+    int sliceShorter;		// was doubled, or halved (SLICE_ADAPTIVE)
+    LinkList *readyList;	// queue of threads that are ready to run,
+				// but not running (SCHED_FIFO)
+    ReadyQueue *prioQueue;	// ready threads by priority (SCHED_PRIO
+				// and SCHED_MLFQ)
+    int lastBoost;		// when we last boosted all priorities
+    RBTree *runTree;		// ready threads by virtual runtime
+				// (SCHED_CFS), or by pass (SCHED_STRIDE
+				// and SCHED_LOTTERY)
+    long long minVruntime;	// smallest virtual runtime (or pass) in 
+				// the system; never goes backwards
+
+    void Boost();		// move every thread back to its base level
+    void Rebucket();		// re-sort prioQueue after a Boost
+    void Charge(Thread *thread);	// add the CPU time "thread" used 
+					// since dispatch to its vruntime
+    void UpdateMinVruntime(Thread *running);
+    bool UsesRunTree() { return (policy == SCHED_CFS 
+	    || policy == SCHED_STRIDE || policy == SCHED_LOTTERY); }
+    RBNode *DrawLottery();		// pick a ready thread at random,
+					// weighted by tickets
 };
 
 #endif // SCHEDULER_H
@@ -37,7 +37,10 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
-    queue = new List;
+    queue = new LinkList;
+    prof = NULL;
+    isMutex = (initialValue == 1);
+    holder = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -51,54 +54,122 @@ Semaphore::~Semaphore()
     delete queue;
 }
 
+//----------------------------------------------------------------------
+// Profile
+// 	If we are profiling contention, count an acquisition of a 
+//	synchronization object, finding its profile the first time.
+//
+//	"prof" is where the object keeps its profile.
+//	"name", "kind" identify the object.
+//	"waitedSince" is when the current thread started to wait for the
+//		object, or -1 if it didn't have to wait.
+//----------------------------------------------------------------------
+
+static void
+Profile(SyncProfile **prof, char *name, SyncKind kind, int waitedSince)
+{
+    if (syncProf == NULL)
+	return;
+    if (*prof == NULL)
+	*prof = syncProf->Find(name, kind);
+    if (waitedSince < 0)
+	(*prof)->Acquired(FALSE, 0);
+    else {
+	(*prof)->Acquired(TRUE, stats->totalTicks - waitedSince);
+	(*prof)->Involve(currentThread->getName());
+    }
+}
+
+// A thread waiting in Semaphore::P.  It lives on the waiting thread's
+// stack, since the thread can't return from P while it is queued, so
+// queueing it allocates nothing.
+
+class SemaphoreWaiter {
+  public:
+    SemaphoreWaiter(Thread *t, int n)
+	{ thread = t; count = n; link.item = this; }
+    Thread *thread;
+    int count;			// how many units it is waiting for
+    ListLink link;		// links it into the semaphore's queue
+};
+
 //----------------------------------------------------------------------
 // Semaphore::P
-// 	Wait until semaphore value > 0, then decrement.  Checking the
+// 	Wait until semaphore value >= n, then subtract n.  Checking the
 //	value and decrementing must be done atomically, so we
 //	need to disable interrupts before checking the value.
 //
+//	If anyone is already waiting, we wait behind them, even if there
+//	is enough for us.  A waiter doesn't take its units when it wakes
+//	up: V takes them off the value on its behalf before waking it, 
+//	so no one can get in between.
+//
 //	Note that Thread::Sleep assumes that interrupts are disabled
 //	when it is called.
+//
+//	"n" is how many units to take.
 //----------------------------------------------------------------------
 
 void
-Semaphore::P()
+Semaphore::P(int n)
 {
     DEBUG('t',"Entering P,disable interrupt\n");
-    //printf("entering P,value=%d\n",value);
     IntStatus oldLevel = interrupt->SetLevel(IntOff);	// disable interrupts
     
-    while (value == 0) { 			// semaphore not available
-	queue->Append((void *)currentThread);	// so go to sleep
+    ASSERT(n > 0);
+    if (value >= n && queue->IsEmpty()) {	// semaphore available,
+	value -= n;				// consume its value
+	if (isMutex && value == 0)
+	    holder = currentThread;
+	Profile(&prof, name, SYNC_SEMAPHORE, -1);
+    } else {					// not available, so
+	SemaphoreWaiter waiter(currentThread, n);	// go to sleep
+	int start = stats->totalTicks;		// until V hands it over
+
+	queue->Append(&waiter.link);
+	currentThread->waitingSema = this;
+	if (deadlock != NULL)
+	    deadlock->Blocking(currentThread);
+	currentThread->acct.Blocking(name);
 	currentThread->Sleep();
+	currentThread->waitingSema = NULL;
+	Profile(&prof, name, SYNC_SEMAPHORE, start);
     } 
-    value--; 					// semaphore available, 
-						// consume its value
     
     (void) interrupt->SetLevel(oldLevel);	// re-enable interrupts
     DEBUG('t',"Leaving P,enable interrupt\n");
-    //printf("leaving P,value=%d\n",value);
 }
 
 //----------------------------------------------------------------------
 // Semaphore::V
-// 	Increment semaphore value, waking up a waiter if necessary.
-//	As with P(), this operation must be atomic, so we need to disable
-//	interrupts.  Scheduler::ReadyToRun() assumes that threads
-//	are disabled when it is called.
+// 	Add n to the semaphore value, and wake up the waiters at the head
+//	of the queue, for as long as there is enough to give each one all
+//	it is waiting for.  As with P(), this operation must be atomic, so 
+//	we need to disable interrupts.  Scheduler::ReadyToRun() assumes 
+//	that threads are disabled when it is called.
+//
+//	"n" is how many units to give back.
 //----------------------------------------------------------------------
 
 void
-Semaphore::V()
+Semaphore::V(int n)
 {
-    Thread *thread;
+    SemaphoreWaiter *waiter;
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-    thread = (Thread *)queue->Remove();
-   // printf("next thread:%s\n",thread->getName());
-    if (thread != NULL)	   // make thread ready, consuming the V immediately
-	scheduler->ReadyToRun(thread);
-    value++;
+    ASSERT(n > 0);
+    value += n;
+    holder = NULL;
+    while ((waiter = (SemaphoreWaiter *)queue->Remove()) != NULL) {
+	if (waiter->count > value) {		// can't satisfy it yet, nor
+	    queue->Prepend(&waiter->link);	// anyone behind it
+	    break;
+	}
+	value -= waiter->count;			// make thread ready, 
+	scheduler->ReadyToRun(waiter->thread);	// consuming the V for it
+	if (isMutex && value == 0)
+	    holder = waiter->thread;
+    }
     (void) interrupt->SetLevel(oldLevel);
 }
 
@@ -110,13 +181,15 @@ Semaphore::V()
 //Lock::Lock
 // Initialize lock to be FREE
 // debugName is useful for debugging
-// using semaphore to implement it
 //---------------------------------------------------------------------
 Lock::Lock(char* debugName) 
 {
     name=debugName;
-    mutex=new Semaphore(debugName,1);
     cur=NULL;
+    queue=new ReadyQueue;
+    nextHeld=NULL;
+    prof=NULL;
+    heldSince=0;
 }
 //---------------------------------------------------------------------
 //Lock::~Lock
@@ -125,28 +198,164 @@ Lock::Lock(char* debugName)
 Lock::~Lock()
 {
     name=NULL;
-    delete mutex;
+    delete queue;
     cur=NULL;
 }
 //--------------------------------------------------------------------
 //Lock::Acquire
-// get the lock,if it is taken, then wait for it
+// get the lock,if it is taken, then wait for it.  While we wait, the
+// holder inherits our priority if it is less important than we are.
+// We don't have to check the lock again when we wake up: Release only
+// wakes us once it has made us the holder.
+//
+// A FREE lock is taken without disabling interrupts: threads only 
+// change turns when interrupts are re-enabled, or a thread goes to
+// sleep, so no one can get in between checking the lock and taking
+// it.  Only a thread that has to wait turns interrupts off -- and 
+// since re-enabling them advances the simulated time, an uncontended
+// lock now costs no time at all.
 //--------------------------------------------------------------------
 void 
 Lock::Acquire()
 {
-    mutex->P();
-    cur=currentThread;
+    stats->numLockAcquires++;
+    if (cur == NULL) {				// fast path: FREE
+	Take(currentThread);
+	Profile(&prof, name, SYNC_LOCK, -1);
+	return;
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = stats->totalTicks;
+
+    stats->numLockWaits++;
+    queue->Append(currentThread);		// lock is BUSY
+    currentThread->waitingOn = this;
+    Donate(currentThread->getPrio());
+    if (deadlock != NULL)
+	deadlock->Blocking(currentThread);
+    currentThread->acct.Blocking(name);
+    currentThread->Sleep();
+    ASSERT(cur == currentThread);		// handed to us by Release
+    Profile(&prof, name, SYNC_LOCK, start);
+    (void) interrupt->SetLevel(oldLevel);
 }
 //--------------------------------------------------------------------
 //Lock::Release
-// release the lock,wake up one is there are any
+// release the lock, and give up any priority inherited through it.
+// If there are waiters, the lock goes straight to the most important
+// one before it is woken up, so that neither we nor any other thread
+// can take it back in the meantime.  With no one waiting, there is no
+// one to wake and nothing inherited through this lock, so, like 
+// Acquire, we can leave interrupts alone.
 //--------------------------------------------------------------------
 void 
 Lock::Release()
 {
-    mutex->V();
-    cur=NULL;
+    Thread *holder = cur;
+    Thread *thread;
+    int prio;
+
+    ASSERT(holder != NULL);
+    if (queue->IsEmpty()) {			// fast path: no waiters
+	Drop();
+	return;
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    Drop();
+    prio = holder->getBasePrio();		// what is it still owed?
+    for (Lock *lock = holder->heldLocks; lock != NULL; lock = lock->nextHeld)
+	prio = min(prio, lock->queue->HighestPrio());
+    if (prio > holder->getPrio())
+	SetPrio(holder, prio);
+
+    thread = queue->Remove();
+    thread->waitingOn = NULL;
+    Take(thread);
+    scheduler->ReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+//--------------------------------------------------------------------
+//Lock::Take, Lock::Drop
+// make "thread" the holder of the lock, on its list of locks held; 
+// or take the lock off its holder's list, and mark it FREE.  Either
+// must be done without a context switch in the middle.
+// If we are profiling, Drop counts how long the lock was held.
+//--------------------------------------------------------------------
+void
+Lock::Take(Thread *thread)
+{
+    cur = thread;
+    nextHeld = cur->heldLocks;
+    cur->heldLocks = this;
+    heldSince = stats->totalTicks;
+}
+void
+Lock::Drop()
+{
+    Lock **link;
+
+    for (link = &cur->heldLocks; *link != this; link = &(*link)->nextHeld)
+	ASSERT(*link != NULL);
+    *link = nextHeld;
+    nextHeld = NULL;
+    cur = NULL;
+    if (prof != NULL)
+	prof->Held(stats->totalTicks - heldSince);
+}
+//--------------------------------------------------------------------
+//Lock::Enqueue
+// "thread" was waiting on a condition variable, and has been signalled;
+// the caller holds this lock.  Rather than wake the thread, just to 
+// have it find the lock busy, put it straight among our waiters, so 
+// it is woken up when the lock is released.
+//--------------------------------------------------------------------
+void
+Lock::Enqueue(Thread *thread)
+{
+    ASSERT(cur != NULL && thread->waitingOn == NULL);
+    queue->Append(thread);
+    thread->waitingOn = this;
+    Donate(thread->getPrio());
+}
+//--------------------------------------------------------------------
+//Lock::Donate
+// the current thread, at priority "prio", is about to wait for this
+// lock: raise the holder to "prio" if it is less important, and if 
+// the holder is itself waiting for a lock, do the same for that one's
+// holder, and so on.  The walk stops at the first thread that is
+// already important enough, so a deadlocked cycle doesn't loop.
+//--------------------------------------------------------------------
+void
+Lock::Donate(int prio)
+{
+    for (Lock *lock = this; lock != NULL; lock = lock->cur->waitingOn) {
+	if (lock->cur == NULL || lock->cur->getPrio() <= prio)
+	    break;
+	DEBUG('t', "Thread \"%s\" inherits priority %d through lock \"%s\"\n",
+	      lock->cur->getName(), prio, lock->name);
+	SetPrio(lock->cur, prio);
+    }
+}
+//--------------------------------------------------------------------
+//Lock::SetPrio
+// change a thread's priority.  If it is waiting for a lock, move it 
+// to its new place among that lock's waiters; otherwise, let the 
+// scheduler move it on its ready queue, if it is on one.
+//--------------------------------------------------------------------
+void
+Lock::SetPrio(Thread *thread, int prio)
+{
+    Lock *lock = thread->waitingOn;
+
+    if (lock != NULL) {
+	lock->queue->Unlink(thread);
+	thread->setPrio(prio);
+	lock->queue->Append(thread);
+    } else
+	cpuSet->ChangePrio(thread, prio);
 }
 //--------------------------------------------------------------------
 //Lock::isHeldByCurrentThread
@@ -166,7 +375,8 @@ Lock::isHeldByCurrentThread()
 Condition::Condition(char* debugName)
 {
     name=debugName;
-    waitqueue=new List();
+    waitqueue=new LinkList();
+    prof=NULL;
 }
 //-------------------------------------------------------------------
 //Condition::~Condition
@@ -178,88 +388,208 @@ Condition::~Condition()
 }
 //-------------------------------------------------------------------
 //Condition::Wait(Lock* conditionLock)
-// releasing the lock and going to sleep,when signaled regain the lock
+// releasing the lock and going to sleep,when signaled regain the lock.
+// Signal moves us onto the lock's queue, so we are only woken up once
+// the lock has been handed to us.  The time waited runs until then.
 //-------------------------------------------------------------------
 void 
 Condition::Wait(Lock* conditionLock)
 {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int start = stats->totalTicks;
+
     ASSERT(conditionLock->isHeldByCurrentThread());
-    conditionLock->Release();
-    waitqueue->Append(currentThread);
+    conditionLock->Release();		// no Signal can come in between
+    waitqueue->Append(&currentThread->listLink);	// with interrupts off
+    currentThread->acct.Blocking(name);
     currentThread->Sleep();
-    conditionLock->Acquire();
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    stats->numLockAcquires++;
+    Profile(&conditionLock->prof, conditionLock->name, SYNC_LOCK, -1);
+    Profile(&prof, name, SYNC_CONDITION, start);
+    (void) interrupt->SetLevel(oldLevel);
 }
 //-------------------------------------------------------------------
 //Condition::Signal(Lock* conditionLock)
-// wake up a corresponding thread
+// wake up a corresponding thread, by moving it onto the lock's queue;
+// it runs once the lock is released to it
 //-------------------------------------------------------------------
 void
 Condition::Signal(Lock* conditionLock)
 {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
     ASSERT(conditionLock->isHeldByCurrentThread());
     if(!waitqueue->IsEmpty())
-    {
-        Thread* nextThread=(Thread*)waitqueue->Remove();
-        scheduler->ReadyToRun(nextThread);
-    }
+        conditionLock->Enqueue((Thread*)waitqueue->Remove());
+    (void) interrupt->SetLevel(oldLevel);
 }
 //------------------------------------------------------------------
 //Condition::Broadcast(Lock* conditionLock)
-// wake up all corresponding threads
+// wake up all corresponding threads, moving them all onto the lock's
+// queue, so they get the lock one at a time instead of all waking up
+// to fight over it
 //------------------------------------------------------------------
 void 
 Condition::Broadcast(Lock* conditionLock)
 {
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
     ASSERT(conditionLock->isHeldByCurrentThread());
     while(!waitqueue->IsEmpty())
-    {
-        Thread* nextThread=(Thread*)waitqueue->Remove();
-        scheduler->ReadyToRun(nextThread);
-    }
+        conditionLock->Enqueue((Thread*)waitqueue->Remove());
+    (void) interrupt->SetLevel(oldLevel);
 }
 
-RWLock::RWLock(char*debugName)
+//-------------------------------------------------------------------
+//RWLock::RWLock
+// Initialize a readers/writer lock to be FREE
+// "p" decides whether readers or writers go first, see synch.h
+//-------------------------------------------------------------------
+RWLock::RWLock(char* debugName, RWPolicy p)
 {
     name=debugName;
+    policy=p;
+    mutex=new Lock(debugName);
+    readOk=new Condition(debugName);
+    writeOk=new Condition(debugName);
     readers=0;
-    rw=new Lock("sem");
-    mutex=new Lock("mutex");
+    writing=FALSE;
+    waitingReaders=waitingWriters=0;
+    readBatch=0;
+    writeGrants=0;
+    prof=NULL;
+    heldSince=0;
 }
-
+//-------------------------------------------------------------------
+//RWLock::~RWLock
+// Deallocate the lock.  Assume no one holds it, or is waiting for it.
+//-------------------------------------------------------------------
 RWLock::~RWLock()
 {
     name=NULL;
-    delete rw;
     delete mutex;
+    delete readOk;
+    delete writeOk;
 }
-
+//-------------------------------------------------------------------
+//RWLock::RAcquire
+// start reading.  With no writer around, just count ourselves in;
+// otherwise wait for our batch of readers to be let in, and the 
+// writer letting us in has counted us already.
+//-------------------------------------------------------------------
 void
 RWLock::RAcquire()
 {
+    int start = -1;
+
     mutex->Acquire();
-    readers++;
-    if(readers==1)rw->Acquire();
+    if (!writing && (policy == RW_PREFER_READERS || waitingWriters == 0)) {
+	if (readers++ == 0)
+	    heldSince = stats->totalTicks;
+    } else {
+	int batch = readBatch;
+
+	start = stats->totalTicks;
+	waitingReaders++;
+	while (readBatch == batch)
+	    readOk->Wait(mutex);
+    }
+    Profile(&prof, name, SYNC_RWLOCK, start);
     mutex->Release();
 }
-
+//-------------------------------------------------------------------
+//RWLock::RRelease
+// done reading; the last reader out lets a writer in
+//-------------------------------------------------------------------
 void
 RWLock::RRelease()
 {
     mutex->Acquire();
+    ASSERT(readers > 0);
     readers--;
-    if(readers==0)rw->Release();
+    if (readers == 0 && waitingWriters > 0)
+	AdmitWriter();
+    CheckFree();
     mutex->Release();
 }
-
+//-------------------------------------------------------------------
+//RWLock::WAcquire
+// start writing, once no one else holds the lock.  If we have to 
+// wait, whoever lets us in marks the lock as being written for us.
+//-------------------------------------------------------------------
 void
 RWLock::WAcquire()
 {
-    rw->Acquire();
-}
+    int start = -1;
 
+    mutex->Acquire();
+    if (!writing && readers == 0 && waitingWriters == 0) {
+	writing = TRUE;
+	heldSince = stats->totalTicks;
+    } else {
+	start = stats->totalTicks;
+	waitingWriters++;
+	while (writeGrants == 0)
+	    writeOk->Wait(mutex);
+	writeGrants--;
+    }
+    Profile(&prof, name, SYNC_RWLOCK, start);
+    mutex->Release();
+}
+//-------------------------------------------------------------------
+//RWLock::WRelease
+// done writing; hand the lock to the waiting readers or to the next
+// writer, depending on the policy
+//-------------------------------------------------------------------
 void
 RWLock::WRelease()
 {
-    rw->Release();
+    mutex->Acquire();
+    ASSERT(writing);
+    writing = FALSE;
+    if (waitingReaders > 0 
+	    && (policy != RW_PREFER_WRITERS || waitingWriters == 0))
+	AdmitReaders();
+    else if (waitingWriters > 0)
+	AdmitWriter();
+    CheckFree();
+    mutex->Release();
+}
+//-------------------------------------------------------------------
+//RWLock::AdmitReaders
+// let all the waiting readers in at once, with one Broadcast
+//-------------------------------------------------------------------
+void
+RWLock::AdmitReaders()
+{
+    readers += waitingReaders;
+    waitingReaders = 0;
+    readBatch++;
+    readOk->Broadcast(mutex);
+}
+//-------------------------------------------------------------------
+//RWLock::AdmitWriter
+// let one waiting writer in
+//-------------------------------------------------------------------
+void
+RWLock::AdmitWriter()
+{
+    writing = TRUE;
+    waitingWriters--;
+    writeGrants++;
+    writeOk->Signal(mutex);
+}
+//-------------------------------------------------------------------
+//RWLock::CheckFree
+// if we are profiling, and the lock has just become FREE, count how 
+// long it was held.  The lock is handed straight from one holder to 
+// the next while anyone waits, so this is the time since it was last
+// FREE, not the time any one thread held it.
+//-------------------------------------------------------------------
+void
+RWLock::CheckFree()
+{
+    if (prof != NULL && readers == 0 && !writing)
+	prof->Held(stats->totalTicks - heldSince);
 }
-    
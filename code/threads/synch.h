@@ -20,6 +20,8 @@
 #include "copyright.h"
 #include "thread.h"
 #include "list.h"
+#include "scheduler.h"
+#include "synchprof.h"
 
 // The following class defines a "semaphore" whose value is a non-negative
 // integer.  The semaphore has only two operations P() and V():
@@ -27,6 +29,17 @@
 //	P() -- waits until value > 0, then decrement
 //
 //	V() -- increment, waking up a thread waiting in P() if necessary
+//
+// P(n) and V(n) do the same n units at a time, atomically: P(n) waits 
+// until it can take all n at once.  Waiters are served strictly in 
+// FIFO order -- a P that has to wait holds up every P after it, even 
+// one for fewer units, so that a large request can't be starved by a
+// stream of small ones.  V(n) hands its units straight to as many of 
+// the waiters at the head of the queue as it can satisfy, in one pass.
+//
+// A semaphore created with value 1 is usually a mutex, so we remember
+// which thread took it down to 0, until the next V, for the deadlock
+// detector (see deadlock.h).
 // 
 // Note that the interface does *not* allow a thread to read the value of 
 // the semaphore directly -- even if you did read the value, the
@@ -42,13 +55,20 @@ class Semaphore {
     ~Semaphore();   					// de-allocate semaphore
     char* getName() { return name;}			// debugging assist
     
-    void P();	 // these are the only operations on a semaphore
-    void V();	 // they are both *atomic*
+    void P(int n = 1);	 // these are the only operations on a semaphore
+    void V(int n = 1);	 // they are both *atomic*
     
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List *queue;       // threads waiting in P() for the value to be > 0
+    LinkList *queue;   // threads waiting in P(), and how many units 
+		       // each wants, in FIFO order
+    SyncProfile *prof; // contention profile, if profiling
+    bool isMutex;      // was the initial value 1?
+    Thread *holder;    // if so, the thread that took it down to 0,
+		       // and hasn't given it back yet; else NULL
+
+    friend class DeadlockDetector;
 };
 
 // The following class defines a "lock".  A lock can be BUSY or FREE.
@@ -62,6 +82,16 @@ class Semaphore {
 // In addition, by convention, only the thread that acquired the lock
 // may release it.  As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// Locks implement priority inheritance: while a thread waits for a 
+// lock, the holder runs at the waiter's priority if that is higher 
+// than its own, so that threads of middling priority can't keep the
+// waiter from running indefinitely by keeping the holder from running.
+// If the holder is itself waiting for another lock, that lock's holder
+// is raised as well, and so on down the chain.  Release hands the lock
+// to the most important waiter, and drops the releasing thread back to
+// its base priority -- or to the priority of the most important thread
+// still waiting for some other lock it holds.
 
 class Lock {
   public:
@@ -79,9 +109,24 @@ class Lock {
 
   private:
     char* name;				// for debugging
-    Semaphore* mutex;
-    Thread* cur;
-    // plus some other stuff you'll need to define
+    Thread* cur;			// holder, or NULL if FREE
+    ReadyQueue *queue;			// threads waiting in Acquire, by
+					// priority
+    Lock *nextHeld;			// next lock held by the same thread
+    SyncProfile *prof;			// contention profile, if profiling
+    int heldSince;			// when it was last acquired
+
+    void Take(Thread *thread);		// make "thread" the holder
+    void Drop();			// make the lock FREE
+    void Donate(int prio);		// raise the holder (and whoever
+					// holds what it waits for) to "prio"
+    static void SetPrio(Thread *thread, int prio);
+
+    friend class Condition;
+    void Enqueue(Thread *thread);	// make a thread woken up by a 
+					// Condition wait for us instead
+
+    friend class DeadlockDetector;
 };
 
 // The following class defines a "condition variable".  A condition
@@ -115,6 +160,12 @@ class Lock {
 // The consequence of using Mesa-style semantics is that some other thread
 // can acquire the lock, and change data structures, before the woken
 // thread gets a chance to run.
+//
+// Signal and Broadcast don't make the woken threads ready at once: 
+// since the signaller holds the lock, they would only run to find it 
+// busy, and go straight back to sleep waiting for it.  Instead they are
+// moved onto the lock's queue of waiters ("wait morphing"), and each
+// one is made ready only when the lock is released to it.
 
 class Condition {
   public:
@@ -133,25 +184,75 @@ class Condition {
 
   private:
     char* name;
-    List* waitqueue;
-    // plus some other stuff you'll need to define
+    LinkList* waitqueue;
+    SyncProfile *prof;			// contention profile, if profiling
 };
-//read-write lock
-// multiple read and only write
-class RWLock{
-    public:
-        RWLock(char*debugName);
-        ~RWLock();
-        char*getName(){ return name;  }
-        void RAcquire();
-        void RRelease();
-        void WAcquire();
-        void WRelease();
-        int getreads(){ return readers;  }
-    private:
-        char* name;
-        int readers;// recording the number of readers
-        Lock* rw;
-        Lock* mutex;
+// The following class defines a "readers/writer lock".  Any number of
+// readers may hold it at once, or else a single writer:
+//
+//	RAcquire -- wait until no writer holds the lock, then read
+//
+//	RRelease -- done reading; if this was the last reader, let a 
+//		waiting writer in
+//
+//	WAcquire -- wait until no one holds the lock, then write
+//
+//	WRelease -- done writing; let the next writer, or all the 
+//		waiting readers together, in
+//
+// The policy decides who goes first when both readers and writers are
+// waiting:
+//
+//	RW_PREFER_READERS -- a reader never waits while others are 
+//		reading, even if a writer is waiting; under a steady 
+//		stream of readers, writers starve
+//	RW_PREFER_WRITERS -- no reader gets in while a writer is waiting,
+//		and a departing writer hands over to the next writer; 
+//		now readers can starve
+//	RW_PHASE_FAIR -- reading and writing phases alternate: readers 
+//		arriving while a writer waits hold back, but a departing 
+//		writer admits every reader waiting at that moment before
+//		the next writer, so neither side waits for more than one 
+//		phase of the other
+//
+// Waiting readers are always admitted as a batch, with a single 
+// Broadcast.  The lock is handed directly to the threads it admits, so
+// a newcomer cannot slip in while they wait to be scheduled.
+
+enum RWPolicy { RW_PREFER_READERS, RW_PREFER_WRITERS, RW_PHASE_FAIR };
+
+class RWLock {
+  public:
+    RWLock(char* debugName, RWPolicy p = RW_PREFER_READERS);
+    ~RWLock();
+    char* getName() { return name; }
+
+    void RAcquire();
+    void RRelease();
+    void WAcquire();
+    void WRelease();
+    int getreads() { return readers; }	// number of readers now
+
+  private:
+    char* name;
+    RWPolicy policy;
+    Lock* mutex;			// protects the fields below
+    Condition* readOk;			// waiting readers
+    Condition* writeOk;			// waiting writers
+    int readers;			// readers holding the lock
+    bool writing;			// is a writer holding the lock?
+    int waitingReaders, waitingWriters;
+    int readBatch;			// bumped each time the waiting
+					// readers are let in
+    int writeGrants;			// writers let in, but not yet
+					// woken up
+    SyncProfile *prof;			// contention profile, if profiling
+    int heldSince;			// when readers or a writer last
+					// took it while it was FREE
+
+    void AdmitReaders();		// let every waiting reader in
+    void AdmitWriter();			// let one waiting writer in
+    void CheckFree();			// profile the hold, if now FREE
 };
+
 #endif // SYNC:H_H
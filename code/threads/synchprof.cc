@@ -0,0 +1,191 @@
+// synchprof.cc
+//	Routines to profile contention on synchronization objects, and
+//	to report on it when Nachos halts.
+//
+//	NOTE: the profile is updated by the synchronization routines,
+//	at points where no other thread can run in between, so it needs
+//	no mutual exclusion of its own.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchprof.h"
+
+static char *kindNames[] = { "semaphore", "lock", "condition", "rwlock" };
+
+//----------------------------------------------------------------------
+// SyncProfile::SyncProfile
+// 	Initialize the profile of the objects with a given name and kind:
+//	nothing has happened to them yet.
+//----------------------------------------------------------------------
+
+SyncProfile::SyncProfile(char *debugName, SyncKind k)
+{
+    name = debugName;
+    kind = k;
+    acquires = contended = 0;
+    waitTicks = maxWait = 0;
+    holdTicks = maxHold = 0;
+    numThreads = 0;
+    moreThreads = FALSE;
+    next = NULL;
+}
+
+//----------------------------------------------------------------------
+// SyncProfile::Acquired
+// 	Count one acquisition (or, for a condition variable, one wait).
+//
+//	"waited" is TRUE if the thread had to wait.
+//	"ticks" is how long it waited.
+//----------------------------------------------------------------------
+
+void
+SyncProfile::Acquired(bool waited, int ticks)
+{
+    acquires++;
+    if (!waited)
+	return;
+    contended++;
+    waitTicks += ticks;
+    maxWait = max(maxWait, ticks);
+}
+
+//----------------------------------------------------------------------
+// SyncProfile::Held
+// 	Count the time a lock was held, from acquire to release.
+//
+//	"ticks" is how long it was held.
+//----------------------------------------------------------------------
+
+void
+SyncProfile::Held(int ticks)
+{
+    holdTicks += ticks;
+    maxHold = max(maxHold, ticks);
+}
+
+//----------------------------------------------------------------------
+// SyncProfile::Involve
+// 	Remember the name of a thread that had to wait, unless we already
+//	have it, or have as many names as we keep.
+//
+//	"thread" is the name of the thread.
+//----------------------------------------------------------------------
+
+void
+SyncProfile::Involve(char *thread)
+{
+    for (int i = 0; i < numThreads; i++)
+	if (threads[i] == thread || !strcmp(threads[i], thread))
+	    return;
+    if (numThreads < MaxProfThreads)
+	threads[numThreads++] = thread;
+    else
+	moreThreads = TRUE;
+}
+
+//----------------------------------------------------------------------
+// SyncProfiler::SyncProfiler
+// 	Initialize the profiler, with no profiles.
+//----------------------------------------------------------------------
+
+SyncProfiler::SyncProfiler()
+{
+    profiles = NULL;
+    numProfiles = 0;
+}
+
+//----------------------------------------------------------------------
+// SyncProfiler::~SyncProfiler
+// 	De-allocate the profiles.  No object may use its profile after
+//	this.
+//----------------------------------------------------------------------
+
+SyncProfiler::~SyncProfiler()
+{
+    while (profiles != NULL) {
+	SyncProfile *prof = profiles;
+
+	profiles = prof->next;
+	delete prof;
+    }
+}
+
+//----------------------------------------------------------------------
+// SyncProfiler::Find
+// 	Find the profile for the objects with a name and kind, making a
+//	new one the first time.
+//
+//	"name" is the object's name.
+//	"kind" is what sort of object it is.
+//----------------------------------------------------------------------
+
+SyncProfile *
+SyncProfiler::Find(char *name, SyncKind kind)
+{
+    SyncProfile *prof;
+
+    if (name == NULL)
+	name = "(no name)";
+    for (prof = profiles; prof != NULL; prof = prof->next)
+	if (prof->kind == kind
+		&& (prof->name == name || !strcmp(prof->name, name)))
+	    return prof;
+    prof = new SyncProfile(name, kind);
+    prof->next = profiles;
+    profiles = prof;
+    numProfiles++;
+    return prof;
+}
+
+//----------------------------------------------------------------------
+// SyncProfiler::Print
+// 	Print a table of the profiles, the most contended first: by the
+//	number of acquisitions that had to wait, then by the total time
+//	waited.  Under each, name the threads that had to wait.
+//----------------------------------------------------------------------
+
+static bool
+MoreContended(SyncProfile *a, SyncProfile *b)
+{
+    if (a->contended != b->contended)
+	return (a->contended > b->contended);
+    return (a->waitTicks > b->waitTicks);
+}
+
+void
+SyncProfiler::Print()
+{
+    SyncProfile **sorted = new SyncProfile *[numProfiles];
+    SyncProfile *prof;
+    int i, j;
+
+    for (i = 0, prof = profiles; prof != NULL; i++, prof = prof->next) {
+	for (j = i; j > 0 && MoreContended(prof, sorted[j - 1]); j--)
+	    sorted[j] = sorted[j - 1];		// insertion sort
+	sorted[j] = prof;
+    }
+
+    printf("Synchronization profile, most contended first (ticks):\n");
+    printf("%-9s %-16s %8s %8s %8s %7s %8s %7s\n", "kind", "name",
+	   "acquires", "waited", "wait", "max", "held", "max");
+    for (i = 0; i < numProfiles; i++) {
+	prof = sorted[i];
+	printf("%-9s %-16s %8d %8d %8d %7d ", kindNames[prof->kind],
+	       prof->name, prof->acquires, prof->contended,
+	       prof->waitTicks, prof->maxWait);
+	if (prof->kind == SYNC_LOCK || prof->kind == SYNC_RWLOCK)
+	    printf("%8d %7d\n", prof->holdTicks, prof->maxHold);
+	else
+	    printf("%8s %7s\n", "-", "-");
+	if (prof->numThreads == 0)
+	    continue;
+	printf("%26s waiters:", "");
+	for (j = 0; j < prof->numThreads; j++)
+	    printf(" %s", prof->threads[j]);
+	printf("%s\n", prof->moreThreads ? " ..." : "");
+    }
+    delete [] sorted;
+}
@@ -0,0 +1,80 @@
+// synchprof.h
+//	Data structures for profiling contention on synchronization
+//	objects: semaphores, locks, condition variables and readers/writer
+//	locks.
+//
+//	Objects are profiled by name, so that all the locks called
+//	"list lock", say, count as one; each kind of object is kept apart,
+//	since the same name is often given to a lock and the condition
+//	variables used with it.  For each, we count how many times it was
+//	acquired (for a condition variable, waited on), how many of those
+//	had to wait, how long they waited, how long the object was held
+//	(locks only), and the names of the first few threads that had to
+//	wait for it.
+//
+//	Profiling is off unless asked for, with "-lockprof"; then a
+//	report of the most contended objects is printed when Nachos halts.
+//	Each object finds its profile once, the first time it is used, so
+//	the cost per operation is a few additions.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYNCHPROF_H
+#define SYNCHPROF_H
+
+#include "copyright.h"
+#include "utility.h"
+
+enum SyncKind { SYNC_SEMAPHORE, SYNC_LOCK, SYNC_CONDITION, SYNC_RWLOCK };
+
+#define MaxProfThreads	4	// waiting threads named per object
+
+// The following class defines the profile of the objects of one kind
+// with one name.  The fields are public, since they are just
+// statistics.
+
+class SyncProfile {
+  public:
+    SyncProfile(char *debugName, SyncKind k);
+
+    void Acquired(bool waited, int ticks);	// it was acquired, after
+					// waiting "ticks" if "waited"
+    void Held(int ticks);		// it was held for "ticks"
+    void Involve(char *thread);		// the named thread had to wait
+
+    char *name;
+    SyncKind kind;
+    int acquires;			// times acquired or waited on
+    int contended;			// ... and the thread had to wait
+    int waitTicks;			// total time spent waiting
+    int maxWait;			// longest single wait
+    int holdTicks;			// total time held
+    int maxHold;			// longest time held at once
+    char *threads[MaxProfThreads];	// threads that had to wait
+    int numThreads;			// number of names in "threads"
+    bool moreThreads;			// were there more than that?
+    SyncProfile *next;			// next profile kept
+};
+
+// The following class keeps the profiles of all the objects, and
+// prints the report when Nachos halts.
+
+class SyncProfiler {
+  public:
+    SyncProfiler();			// no profiles yet
+    ~SyncProfiler();			// de-allocate the profiles
+
+    SyncProfile *Find(char *name, SyncKind kind);	// the profile for
+					// objects with this name and kind,
+					// made if there isn't one yet
+    void Print();			// print the profiles, most
+					// contended first
+
+  private:
+    SyncProfile *profiles;		// every profile, newest first
+    int numProfiles;
+};
+
+#endif // SYNCHPROF_H
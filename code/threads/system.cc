@@ -14,13 +14,22 @@
 Thread *currentThread;			// the thread we are running now
 Thread *threadToBeDestroyed;  		// the thread that just finished
 Scheduler *scheduler;			// the ready list
+CpuSet *cpuSet;				// the simulated CPUs
+Cpu *currentCpu;			// the CPU being simulated right now
 Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
-bool tid_used[128];   //for tid allocation
-int thread_exist;
-Thread* threads[128]; 
+Alarm *alarmClock;			// wakes up sleeping threads
+ThreadTable *threadTable;		// every thread, indexed by ID
+BlockPool *tcbPool;			// recycled thread control blocks
+BlockPool *stackPool;			// recycled thread stacks
+AcctLog *acctLog;			// per-thread accounting report,
+					// NULL unless asked for
+SyncProfiler *syncProf;			// lock contention profile,
+					// NULL unless asked for
+DeadlockDetector *deadlock;		// checks blocking threads for
+					// deadlock, NULL unless asked for
 
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
@@ -65,8 +74,32 @@ TimerInterruptHandler(int dummy)
 {
     DEBUG('t',"Enterring TimerInterruptHandler,used_time:%d\n",currentThread->getUsedtime());
     if (interrupt->getStatus() != IdleMode
-           && currentThread->getUsedtime()>=TimeSlice)
+           && scheduler->TimerTick(currentThread))
 	    interrupt->YieldOnReturn();
+    cpuSet->TimerTick();		// and the other CPUs' threads
+    alarmClock->CallBack();		// wake up threads whose time is up
+}
+
+//----------------------------------------------------------------------
+// SegFaultHandler
+// 	Called when Nachos makes an illegal memory reference, just before
+//	it aborts.  If the address is in a guard page of the current 
+//	thread's stack, the thread has run off the end of its stack; say
+//	so, since otherwise all the user sees is a segmentation fault.
+//
+//	"addr" is the address that caused the fault.
+//----------------------------------------------------------------------
+static void
+SegFaultHandler(int addr)
+{
+    if (currentThread != NULL && currentThread->InStackGuard((char *) addr))
+	fprintf(stderr, "\nStack overflow in thread \"%s\" (address 0x%x): "
+		"increase the stack size passed to Fork\n", 
+		currentThread->getName(), addr);
+    else
+	fprintf(stderr, "\nSegmentation fault at address 0x%x, in thread "
+		"\"%s\"\n", addr, 
+		(currentThread != NULL) ? currentThread->getName() : "none");
 }
 
 //----------------------------------------------------------------------
@@ -85,13 +118,16 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    SchedPolicy policy = SCHED_FIFO;
+    SlicePolicy slice = SLICE_FIXED;
+    int poolHighWater = DefaultPoolHighWater;
+    int numCpus = 1;
+    bool acct = FALSE;
+    char *acctFile = NULL;
+    bool lockProf = FALSE;
+    bool detect = FALSE;
 
-    for(int i=0;i<128;i++) //set all tid numbers available
-    {
-        tid_used[i]=false;
-        threads[i]=NULL;
-    }
-    thread_exist=-1;  //set origin number of current threads -1
+    threadTable = new ThreadTable(InitialThreadTableSize);
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
 #endif
@@ -118,7 +154,56 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
-	}
+	} else if (!strcmp(*argv, "-sched")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "fifo"))
+		policy = SCHED_FIFO;
+	    else if (!strcmp(*(argv + 1), "prio"))
+		policy = SCHED_PRIO;
+	    else if (!strcmp(*(argv + 1), "mlfq"))
+		policy = SCHED_MLFQ;
+	    else if (!strcmp(*(argv + 1), "cfs"))
+		policy = SCHED_CFS;
+	    else if (!strcmp(*(argv + 1), "stride"))
+		policy = SCHED_STRIDE;
+	    else if (!strcmp(*(argv + 1), "lottery"))
+		policy = SCHED_LOTTERY;
+	    else {
+		printf("Unknown scheduling policy \"%s\"\n", *(argv + 1));
+		ASSERT(FALSE);
+	    }
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-slice")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "fixed"))
+		slice = SLICE_FIXED;
+	    else if (!strcmp(*(argv + 1), "adaptive"))
+		slice = SLICE_ADAPTIVE;
+	    else {
+		printf("Unknown time slice policy \"%s\"\n", *(argv + 1));
+		ASSERT(FALSE);
+	    }
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-cpus")) {
+	    ASSERT(argc > 1);
+	    numCpus = atoi(*(argv + 1));
+	    ASSERT(numCpus >= 1 && numCpus <= MaxCpus);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-pool")) {
+	    ASSERT(argc > 1);
+	    poolHighWater = atoi(*(argv + 1));
+	    ASSERT(poolHighWater >= 0);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-acct")) {	// per-thread accounting,
+	    acct = TRUE;			// optionally also as CSV
+	    if (argc > 1 && **(argv + 1) != '-') {
+		acctFile = *(argv + 1);
+		argCount = 2;
+	    }
+	} else if (!strcmp(*argv, "-lockprof"))	// lock contention profile
+	    lockProf = TRUE;
+	else if (!strcmp(*argv, "-deadlock"))	// deadlock detection
+	    detect = TRUE;
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
@@ -143,20 +228,32 @@ Initialize(int argc, char **argv)
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
     interrupt = new Interrupt;			// start up interrupt handling
-    scheduler = new Scheduler();		// initialize the ready queue
+    cpuSet = new CpuSet(numCpus, policy, slice); // initialize the ready
+						// queues
+    currentCpu = cpuSet->GetCpu(0);		// we start out on CPU 0
+    scheduler = currentCpu->scheduler;
+    tcbPool = new BlockPool("TCB", sizeof(Thread), poolHighWater, FALSE);
+    stackPool = new BlockPool("Stack", StackSize * sizeof(int), 
+			      poolHighWater, TRUE);
     //if (randomYield)				// start the timer (if needed)
 	    timer = new Timer(TimerInterruptHandler, 0, FALSE);
+    alarmClock = new Alarm;
 
     threadToBeDestroyed = NULL;
+    acctLog = acct ? new AcctLog(acctFile) : NULL;
+    syncProf = lockProf ? new SyncProfiler : NULL;
+    deadlock = detect ? new DeadlockDetector : NULL;
 
     // We didn't explicitly allocate the current thread we are running in.
     // But if it ever tries to give up the CPU, we better have a Thread
     // object to save its state. 
     currentThread = Thread::cap_Thread("main");		
     currentThread->setStatus(RUNNING);
+    currentCpu->current = currentThread;
 
     interrupt->Enable();
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
+    CallOnSegFault(SegFaultHandler);		// if a stack overflows
     
 #ifdef USER_PROGRAM
     machine = new Machine(debugUserProg);	// this must come first
@@ -183,6 +280,21 @@ void
 Cleanup()
 {
     printf("\nCleaning up...\n");
+    if (acctLog != NULL) {
+	acctLog->Print();
+	delete acctLog;
+	acctLog = NULL;
+    }
+    if (syncProf != NULL) {
+	syncProf->Print();
+	delete syncProf;
+	syncProf = NULL;
+    }
+    if (deadlock != NULL) {
+	deadlock->Print();
+	delete deadlock;
+	deadlock = NULL;
+    }
 #ifdef NETWORK
     delete postOffice;
 #endif
@@ -200,7 +312,8 @@ Cleanup()
 #endif
     
     delete timer;
-    delete scheduler;
+    delete alarmClock;
+    delete cpuSet;
     delete interrupt;
     
     Exit(0);
@@ -11,10 +11,17 @@
 #include "copyright.h"
 #include "utility.h"
 #include "thread.h"
+#include "threadtable.h"
+#include "blockpool.h"
+#include "acct.h"
+#include "synchprof.h"
+#include "deadlock.h"
 #include "scheduler.h"
+#include "cpu.h"
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "alarm.h"
 
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
@@ -25,12 +32,18 @@ extern void Cleanup();				// Cleanup, called when
 extern Thread *currentThread;			// the thread holding the CPU
 extern Thread *threadToBeDestroyed;  		// the thread that just finished
 extern Scheduler *scheduler;			// the ready list
+extern CpuSet *cpuSet;				// the simulated CPUs
+extern Cpu *currentCpu;				// the CPU being simulated
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
-extern bool tid_used[128];        // for tid allocation
-extern int thread_exist;        //the number of current threads
-extern Thread* threads[128];       // a list of current threads, corresponding to tid
+extern Alarm *alarmClock;			// for threads to sleep a while
+extern ThreadTable *threadTable;		// every thread, indexed by ID
+extern BlockPool *tcbPool;			// recycled thread control blocks
+extern BlockPool *stackPool;			// recycled thread stacks
+extern AcctLog *acctLog;			// per-thread accounting report
+extern SyncProfiler *syncProf;			// lock contention profile
+extern DeadlockDetector *deadlock;		// deadlock detection
 #ifdef USER_PROGRAM
 #include "machine.h"
 extern Machine* machine;	// user program memory and registers
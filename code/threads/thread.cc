@@ -5,6 +5,7 @@
 //		with the caller (this is done in two steps -- first
 //		allocate the Thread object, then call Fork on it)
 //	Finish -- called when the forked procedure finishes, to clean up
+//	Join -- wait for a thread to finish, and get its exit status
 //	Yield -- relinquish control over the CPU to another ready thread
 //	Sleep -- relinquish control over the CPU, but thread is now blocked.
 //		In other words, it will not run again, until explicitly 
@@ -25,15 +26,31 @@
 					// stack overflows
 //----------------------------------------------------------------------
 // Thread::cap_Thread
-//  A capsulation of Thread initialization. To check thread_exist, if the 
-//  number beyond 128,return NULL
+//  A capsulation of Thread initialization.
 //  set priority, the default priority is 15(lowest)
+//  a joinable thread is only deleted once some thread Joins it
 //----------------------------------------------------------------------
 Thread*
-Thread::cap_Thread(char *threadName,int p)
+Thread::cap_Thread(char *threadName,int p,bool join)
 {
-    if(thread_exist==127)return NULL;
-    else return new Thread(threadName,p);
+    return new Thread(threadName,p,join);
+}
+//----------------------------------------------------------------------
+// Thread::operator new, Thread::operator delete
+//  Thread control blocks are recycled through tcbPool rather than 
+//  going to the system allocator for every thread.
+//----------------------------------------------------------------------
+void *
+Thread::operator new(size_t size)
+{
+    ASSERT(size == sizeof(Thread));
+    return (void *) tcbPool->Get();
+}
+
+void
+Thread::operator delete(void *tcb)
+{
+    tcbPool->Put((char *) tcb);
 }
 //----------------------------------------------------------------------
 // Thread::Thread
@@ -41,28 +58,42 @@ Thread::cap_Thread(char *threadName,int p)
 //	Thread::Fork.
 //
 //	"threadName" is an arbitrary string, useful for debugging.
+//	"p" is the thread's priority.
+//	"join" is TRUE if some thread will wait for this one to finish.
 //----------------------------------------------------------------------
 
-Thread::Thread(char* threadName,int p)
+Thread::Thread(char* threadName,int p,bool join)
 {
     name = threadName;
     stackTop = NULL;
     stack = NULL;
+    stackSize = 0;
     status = JUST_CREATED;
     prio=p;
+    basePrio=p;
+    tickets=DefaultTickets(p);
     used_time=0;
     total_time=0;
-    for(int i=0;i<128;i++)
-    {
-        if(!tid_used[i])
-        {
-            Tid=i;
-            tid_used[i]=1;
-            threads[i]=this;
-            break;
-        }
-    }
-    thread_exist += 1;
+    quantum=TimeSlice;
+    readyNext=NULL;
+    treeNode.item=this;
+    listLink.item=this;
+    vruntime=0;
+    passLeft=0;
+    contending=FALSE;
+    shareTickets=0;
+    shareStart=0;
+    entitled=0;
+    chargedAt=0;
+    lastCpu=-1;
+    joinable=join;
+    finished=FALSE;
+    exitStatus=0;
+    joiner=NULL;
+    waitingOn=NULL;
+    heldLocks=NULL;
+    waitingSema=NULL;
+    Tid=threadTable->Add(this);
 #ifdef USER_PROGRAM
     space = NULL;
 #endif
@@ -85,11 +116,20 @@ Thread::~Thread()
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
     ASSERT(this != currentThread);
-    if (stack != NULL)
-	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
-    tid_used[Tid]=0;
-    threads[Tid]=NULL;
-    thread_exist-=1;
+    if (stack != NULL) {
+	if (stackSize == StackSize)	// only the default size is pooled
+	    stackPool->Put((char *) stack);
+	else
+	    DeallocBoundedArray((char *) stack, stackSize * sizeof(int));
+    }
+#ifdef USER_PROGRAM
+    if (userStateOwner == this)		// no need to ever save them now
+	userStateOwner = NULL;
+#endif
+    if (acctLog != NULL)
+	acctLog->Retire(this);
+    Scheduler::RecordShare(this);
+    threadTable->Remove(Tid);
 }
 
 //----------------------------------------------------------------------
@@ -110,20 +150,26 @@ Thread::~Thread()
 // 	
 //	"func" is the procedure to run concurrently.
 //	"arg" is a single argument to be passed to the procedure.
+//	"stackWords" is the size of the thread's stack, in words; a 
+//		thread that does little can get by with far less than
+//		the default.
 //----------------------------------------------------------------------
 
 void 
-Thread::Fork(VoidFunctionPtr func, int arg)
+Thread::Fork(VoidFunctionPtr func, int arg, int stackWords)
 {
     DEBUG('t', "Forking thread \"%s\" with func = 0x%x, arg = %d\n",
 	  name, (int) func, (int*)arg);
     
+    ASSERT(stackWords >= MinStackSize);
+    stackSize = stackWords;
     StackAllocate(func, arg);
 
-    //IntStatus oldLevel = interrupt->SetLevel(IntOff);
-    scheduler->ReadyToRun(this);	// ReadyToRun assumes that interrupts 
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    cpuSet->ReadyToRunNew(this);	// ReadyToRun assumes that interrupts 
 					// are disabled!
-   //(void) interrupt->SetLevel(oldLevel);
+    (void) interrupt->SetLevel(oldLevel); // if the new thread is more
+					// important, we are preempted here
 }    
 
 //----------------------------------------------------------------------
@@ -132,8 +178,9 @@ Thread::Fork(VoidFunctionPtr func, int arg)
 //	that has been allocated for it.  If we had a smarter compiler,
 //	we wouldn't need to worry about this, but we don't.
 //
-// 	NOTE: Nachos will not catch all stack overflow conditions.
-//	In other words, your program may still crash because of an overflow.
+// 	NOTE: most overflows are caught as they happen, by the guard page
+//	below the stack (see InStackGuard); this check is a backstop for 
+//	the ones that skip over the guard page without touching it.
 //
 // 	If you get bizarre results (such as seg faults where there is no code)
 // 	then you *may* need to increase the stack size.  You can avoid stack
@@ -146,16 +193,60 @@ Thread::CheckOverflow()
 {
     if (stack != NULL)
 #ifdef HOST_SNAKE			// Stacks grow upward on the Snakes
-	ASSERT(stack[StackSize - 1] == STACK_FENCEPOST);
+	ASSERT(stack[stackSize - 1] == STACK_FENCEPOST);
 #else
 	ASSERT((int) *stack == (int) STACK_FENCEPOST);
 #endif
 }
 
+//----------------------------------------------------------------------
+// Thread::InStackGuard
+// 	Return TRUE if "addr" is in one of the guard pages on either 
+//	side of the thread's stack.  Used to explain a segmentation 
+//	fault: touching a guard page means the stack overflowed.
+//----------------------------------------------------------------------
+
+bool
+Thread::InStackGuard(char *addr)
+{
+    if (stack == NULL)
+	return FALSE;
+    return InBoundedArrayGuard((char *) stack, stackSize * sizeof(int), addr);
+}
+
+//----------------------------------------------------------------------
+// Thread::setStatus
+// 	Change the thread's state, keeping track of how long it spends 
+//	waiting to be woken up, and then waiting to run.
+//----------------------------------------------------------------------
+
+void
+Thread::setStatus(ThreadStatus st)
+{
+    if (st == READY) {
+	if (status == BLOCKED)
+	    acct.Woken();
+	acct.Ready();
+    } else if (st == RUNNING && status == READY)
+	acct.Running();
+    status = st;
+}
+
 //----------------------------------------------------------------------
 // Thread::Finish
 // 	Called by ThreadRoot when a thread is done executing the 
-//	forked procedure.
+//	forked procedure.  The exit status is 0.
+//----------------------------------------------------------------------
+
+void
+Thread::Finish ()
+{
+    Exit(0);
+}
+
+//----------------------------------------------------------------------
+// Thread::Exit
+// 	Called by a thread that is done, to finish with an exit status.
 //
 // 	NOTE: we don't immediately de-allocate the thread data structure 
 //	or the execution stack, because we're still running in the thread 
@@ -163,24 +254,88 @@ Thread::CheckOverflow()
 //	so that Scheduler::Run() will call the destructor, once we're
 //	running in the context of a different thread.
 //
+//	A joinable thread is instead left for Join to delete.  If some 
+//	thread is already waiting in Join, it is put straight back on the
+//	ready queue; it can't run until we have switched away.
+//
 // 	NOTE: we disable interrupts, so that we don't get a time slice 
 //	between setting threadToBeDestroyed, and going to sleep.
+//
+//	"exitCode" is handed to the thread that Joins this one.
 //----------------------------------------------------------------------
 
 //
 void
-Thread::Finish ()
+Thread::Exit (int exitCode)
 {
     //(void) interrupt->SetLevel(IntOff);		
     ASSERT(this == currentThread);
     
-    DEBUG('t', "Finishing thread \"%s\"\n", getName());
+    DEBUG('t', "Finishing thread \"%s\" with status %d\n", getName(), 
+	  exitCode);
     
-    threadToBeDestroyed = currentThread;
+    exitStatus = exitCode;
+    if (joinable) {
+	finished = TRUE;
+	if (joiner != NULL)
+	    scheduler->ReadyToRun(joiner);
+    } else
+	threadToBeDestroyed = currentThread;
     Sleep();					// invokes SWITCH
     // not reached
 }
 
+//----------------------------------------------------------------------
+// Thread::Join
+// 	Wait for a joinable thread to finish, and then delete it.  Only 
+//	one thread may Join a given thread, and only once; the waiting 
+//	thread sleeps until the thread it is joining calls Exit, which 
+//	wakes it up.
+//
+// Returns:
+//	The exit status of the thread.
+//----------------------------------------------------------------------
+
+int
+Thread::Join()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int code;
+
+    ASSERT(this != currentThread);
+    ASSERT(joinable && joiner == NULL);
+
+    if (!finished) {
+	joiner = currentThread;
+	currentThread->acct.Blocking(name);
+	currentThread->Sleep();
+	ASSERT(finished);
+    }
+    code = exitStatus;
+    delete this;
+
+    (void) interrupt->SetLevel(oldLevel);
+    return code;
+}
+
+//----------------------------------------------------------------------
+// Thread::Detach
+// 	Give up on joining a thread: it is to be deleted as soon as it
+//	finishes, or at once, if it has finished already.
+//----------------------------------------------------------------------
+
+void
+Thread::Detach()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(joinable && joiner == NULL);
+    joinable = FALSE;
+    if (finished)
+	delete this;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
 //----------------------------------------------------------------------
 // Thread::Yield
 // 	Relinquish the CPU if any other thread is ready to run.
@@ -209,15 +364,34 @@ Thread::Yield ()
     
     DEBUG('t', "Yielding thread \"%s\"\n", getName());
     currentThread->resetUsedtime();
-    //scheduler->ReadyToRun(this);
-    nextThread = scheduler->FindNextToRun();
-    if (nextThread != NULL) {
+    // queue ourselves first, so that under a priority discipline we
+    // only give the CPU to a thread that should run before us
     scheduler->ReadyToRun(this);
+    nextThread = cpuSet->FindNextToRun();
+    if (nextThread != this) {
+	acct.Switched(acct.preempted);
 	scheduler->Run(nextThread);
-    }
+    } else
+	setStatus(RUNNING);
     //(void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// Thread::Preempt
+// 	Yield the CPU on behalf of the interrupt handler, because the 
+//	thread's time slice is up or a more important thread is ready.
+//	The same as Yield, except that the switch is counted as one the
+//	thread didn't ask for.
+//----------------------------------------------------------------------
+
+void
+Thread::Preempt()
+{
+    acct.preempted = TRUE;
+    Yield();
+    acct.preempted = FALSE;
+}
+
 //----------------------------------------------------------------------
 // Thread::Sleep
 // 	Relinquish the CPU, because the current thread is blocked
@@ -248,8 +422,13 @@ Thread::Sleep ()
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
     status = BLOCKED;
-    while ((nextThread = scheduler->FindNextToRun()) == NULL)
+    acct.Switched(FALSE);
+    scheduler->StopContending(this);
+    while ((nextThread = cpuSet->FindNextToRun()) == NULL) {
+	if (cpuSet->Idle())	// let another CPU run; returns once
+	    return;		// we've been signalled and run again
 	interrupt->Idle();	// no one to run, wait for an interrupt
+    }
         
     scheduler->Run(nextThread); // returns when we've been signalled
 }
@@ -263,7 +442,7 @@ Thread::Sleep ()
 //----------------------------------------------------------------------
 
 static void ThreadFinish()    { currentThread->Finish(); }
-static void InterruptEnable() { interrupt->Enable(); }
+static void InterruptEnable() { scheduler->Reap(); interrupt->Enable(); }
 void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
 
 //----------------------------------------------------------------------
@@ -281,19 +460,22 @@ void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
 void
 Thread::StackAllocate (VoidFunctionPtr func, int arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    if (stackSize == StackSize)
+	stack = (int *) stackPool->Get();
+    else
+	stack = (int *) AllocBoundedArray(stackSize * sizeof(int));
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
     stackTop = stack + 16;	// HP requires 64-byte frame marker
-    stack[StackSize - 1] = STACK_FENCEPOST;
+    stack[stackSize - 1] = STACK_FENCEPOST;
 #else
     // i386 & MIPS & SPARC stack works from high addresses to low addresses
 #ifdef HOST_SPARC
     // SPARC stack must contains at least 1 activation record to start with.
-    stackTop = stack + StackSize - 96;
+    stackTop = stack + stackSize - 96;
 #else  // HOST_MIPS  || HOST_i386
-    stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
+    stackTop = stack + stackSize - 4;	// -4 to be on the safe side!
 #ifdef HOST_i386
     // the 80386 passes the return address on the stack.  In order for
     // SWITCH() to go to ThreadRoot when we switch to this thread, the
@@ -315,6 +497,8 @@ Thread::StackAllocate (VoidFunctionPtr func, int arg)
 #ifdef USER_PROGRAM
 #include "machine.h"
 
+Thread *Thread::userStateOwner = NULL;
+
 //----------------------------------------------------------------------
 // Thread::SaveUserState
 //	Save the CPU state of a user program on a context switch.
@@ -338,13 +522,26 @@ Thread::SaveUserState()
 //	Note that a user program thread has *two* sets of CPU registers -- 
 //	one for its state while executing user code, one for its state 
 //	while executing kernel code.  This routine restores the former.
+//
+//	The registers are saved lazily: a thread switched out leaves its
+//	user registers in the machine, and they are only saved here, once
+//	some other user thread needs the machine.  So when the CPU goes 
+//	back to the same user thread (perhaps after running only kernel 
+//	threads), there is nothing to copy either way.
 //----------------------------------------------------------------------
 
 void
 Thread::RestoreUserState()
 {
+    stats->numUserRestores++;
+    if (userStateOwner == this)		// still there
+	return;
+    if (userStateOwner != NULL)
+	userStateOwner->SaveUserState();
     for (int i = 0; i < NumTotalRegs; i++)
 	machine->WriteRegister(i, userRegisters[i]);
+    userStateOwner = this;
+    stats->numRegisterLoads++;
 }
 #endif
 
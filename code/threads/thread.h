@@ -24,7 +24,10 @@
 //	that your thread stacks are too small.)
 //	
 //	One thing to try if you find yourself with seg faults is to
-//	increase the size of thread stack -- ThreadStackSize.
+//	increase the size of thread stack -- the "stackSize" argument 
+//	to Fork, or StackSize for the default.  A thread that runs off 
+//	the end of its stack hits an unmapped guard page, and Nachos 
+//	stops with a message naming the thread.
 //
 //  	In this interface, forking a thread takes two steps.
 //	We must first allocate a data structure for it: "t = new Thread".
@@ -39,22 +42,35 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "rbtree.h"
+#include "acct.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
 #include "addrspace.h"
 #endif
 
+class Lock;			// see synch.h
+class Semaphore;
+
 // CPU register state to be saved on context switch.  
 // The SPARC and MIPS only need 10 registers, but the Snake needs 18.
 // For simplicity, this is just the max over all architectures.
 #define MachineStateSize 18 
 
 
-// Size of the thread's private execution stack.
+// Size of the thread's private execution stack, unless another size
+// is passed to Fork.
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
 #define StackSize	(4 * 1024)	// in words
+#define MinStackSize	256		// smallest stack Fork will accept,
+					// also in words
+
 
+// Tickets a thread holds for proportional share scheduling, unless
+// changed with Thread::setTickets: 10 per priority level above the lowest.
+#define DefaultTickets(prio)	((16 - (prio)) * 10)
+#define MaxTickets		65536	// most tickets one thread may hold
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED };
@@ -79,9 +95,13 @@ class Thread {
     // THEY MUST be in this position for SWITCH to work.
     int* stackTop;			 // the current stack pointer
     int machineState[MachineStateSize];  // all registers except for stackTop
-    Thread(char* debugName,int p);
+    Thread(char* debugName,int p,bool join);
   public:
-    static Thread * cap_Thread(char* debugName,int p=15);		// initialize a Thread 
+    static void *operator new(size_t size);	// thread control blocks
+    static void operator delete(void *tcb);	// come from tcbPool
+
+    static Thread * cap_Thread(char* debugName,int p=15,	// initialize a Thread 
+			       bool join=FALSE);	// (joinable, if "join")
     ~Thread(); 				// deallocate a Thread
 					// NOTE -- thread being deleted
 					// must not be running when delete 
@@ -89,16 +109,28 @@ class Thread {
 
     // basic thread operations
 
-    void Fork(VoidFunctionPtr func, int arg); 	// Make thread run (*func)(arg)
+    void Fork(VoidFunctionPtr func, int arg,	// Make thread run (*func)(arg)
+	      int stackWords = StackSize);	// on a stack this many words
     void Yield();  				// Relinquish the CPU if any 
 						// other thread is runnable
+    void Preempt();				// Yield, because of a time
+						// slice or a preemption
     void Sleep();  				// Put the thread to sleep and 
 						// relinquish the processor
     void Finish();  				// The thread is done executing
+    void Exit(int exitCode);			// Finish, leaving "exitCode" 
+						// for Join
+    int Join();					// Wait for a joinable thread
+						// to finish; return its exit
+						// status, and delete it
+    void Detach();				// No one will Join the thread;
+						// delete it once it finishes
     
     void CheckOverflow();   			// Check if thread has 
 						// overflowed its stack
-    void setStatus(ThreadStatus st) { status = st; }
+    bool InStackGuard(char *addr);		// Is addr just off the end
+						// of the thread's stack?
+    void setStatus(ThreadStatus st);
     char* getName() { return (name); }
     void Print() { printf("%s, ", name); }
 
@@ -106,17 +138,31 @@ class Thread {
     unsigned int getUid(){ return this->Uid;  }; //get user ID
     ThreadStatus getStatus(){ return this->status;   } //get current status
     int getPrio(){  return this->prio;  }//get current priority
+    void setPrio(int p){ prio=p;  }  //change current priority
+    int getBasePrio(){ return this->basePrio;  }//priority given at creation
     int getUsedtime(){ return this->used_time;  }
     void resetUsedtime(){ used_time=0;   }
     int getTotaltime(){ return this->total_time;   }
+    long long getVruntime(){ return this->vruntime;   }
+    int getTickets(){ return this->tickets;   }
+    void setTickets(int t){ ASSERT(t>0 && t<=MaxTickets); tickets=t;  }
+    int getLastCpu(){ return this->lastCpu;   }//-1 if it hasn't run yet
+    void setLastCpu(int c){ lastCpu=c;   }
     void advanceTime();
     void addTime();
+
+    ThreadAcct acct;			// CPU accounting, see acct.h
+    ListLink listLink;			// links the thread into the ready
+					// list (SCHED_FIFO), or the list of
+					// threads waiting on a condition
+					// variable or RingQueue
   private:
     // some of the private data for this class is listed above
     
     int* stack; 	 		// Bottom of the stack 
 					// NULL if this is the main thread
 					// (If NULL, don't deallocate stack)
+    int stackSize;			// size of "stack", in words
     ThreadStatus status;		// ready, running or blocked
     char* name;
 
@@ -125,9 +171,40 @@ class Thread {
 					// Used internally by Fork()
     unsigned int Tid,Uid;  //pthread ID and User ID
     int prio;       //priority in scheduling, 0-15, 0 is highest
+    int basePrio;   //priority the thread was created with
+    int tickets;    //share of the CPU under stride/lottery scheduling
     int used_time;    //recording used time slice of threads
+    int quantum;      //length of its time slice (SLICE_ADAPTIVE)
     int total_time;    //recording all time used
 
+    bool joinable;	// will some thread Join this one?
+    bool finished;	// joinable thread that has finished, and is
+			// waiting to be joined
+    int exitStatus;	// what it passed to Exit
+    Thread *joiner;	// thread waiting for it in Join, or NULL
+
+    friend class Lock;
+    friend class Semaphore;
+    friend class DeadlockDetector;
+    Lock *waitingOn;	// lock it is waiting for in Acquire, or NULL
+    Lock *heldLocks;	// locks it holds, linked through Lock::nextHeld
+    Semaphore *waitingSema;	// semaphore it is waiting for in P, or NULL
+
+    friend class ReadyQueue;
+    friend class Scheduler;
+    Thread *readyNext;   //next thread in the same ReadyQueue bucket
+                         //(of a ready queue, or of a Lock's waiters)
+    RBNode treeNode;     //links the thread into the CFS run tree
+    long long vruntime;  //virtual runtime, weighted by priority (CFS)
+    int passLeft;        //StrideOne * ticks run, modulo tickets, not yet
+                         //added to vruntime (SCHED_STRIDE)
+    bool contending;     //ready or running, for proportional share stats
+    int shareTickets;    //tickets held when it started contending
+    double shareStart;   //Scheduler's share clock when it started
+    double entitled;     //CPU time its tickets entitled it to so far
+    int chargedAt;       //when vruntime was last brought up to date
+    int lastCpu;         //CPU it last ran on, for cache affinity
+
 #ifdef USER_PROGRAM
 // A thread running a user program actually has *two* sets of CPU registers -- 
 // one for its state while executing user code, one for its state 
@@ -137,7 +214,14 @@ class Thread {
 
   public:
     void SaveUserState();		// save user-level register state
-    void RestoreUserState();		// restore user-level register state
+    void RestoreUserState();		// restore user-level register state,
+					// unless the machine still has it
+
+  private:
+    static Thread *userStateOwner;	// thread whose user registers the
+					// machine holds, saved only once
+					// another thread's are restored
+  public:
 
     AddrSpace *space;			// User code this thread is running.
 #endif
@@ -0,0 +1,139 @@
+// threadtable.cc 
+//	Routines to allocate thread IDs and to find a thread by its ID.
+//
+//	The free IDs form a singly linked list through the "nextFree"
+//	array, so the next ID to hand out is always at the head of the
+//	list.  Freed IDs are pushed back on the front, so the IDs in use
+//	stay small and the table rarely has to grow.
+//
+//	NOTE: Mutual exclusion must be provided by the caller (thread
+//	creation and deletion run with interrupts disabled, or before
+//	any other thread exists).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "threadtable.h"
+
+//----------------------------------------------------------------------
+// ThreadTable::ThreadTable
+// 	Initialize a thread table, with every ID free.  IDs are handed
+//	out lowest first.
+//
+//	"initialSize" is the number of IDs to start with.
+//----------------------------------------------------------------------
+
+ThreadTable::ThreadTable(int initialSize)
+{
+    ASSERT(initialSize > 0);
+    size = initialSize;
+    count = 0;
+    table = new Thread *[size];
+    nextFree = new int[size];
+    for (int i = 0; i < size; i++) {
+	table[i] = NULL;
+	nextFree[i] = (i + 1 < size) ? i + 1 : -1;
+    }
+    freeHead = 0;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::~ThreadTable
+// 	De-allocate the table.  The threads themselves are not touched.
+//----------------------------------------------------------------------
+
+ThreadTable::~ThreadTable()
+{
+    delete [] table;
+    delete [] nextFree;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Grow
+// 	Double the size of the table, putting the new IDs on the free 
+//	list, lowest first.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Grow()
+{
+    int newSize = size * 2;
+    Thread **newTable = new Thread *[newSize];
+    int *newNext = new int[newSize];
+    int i;
+
+    DEBUG('t', "Growing thread table from %d to %d entries\n", size, newSize);
+    for (i = 0; i < size; i++) {
+	newTable[i] = table[i];
+	newNext[i] = nextFree[i];
+    }
+    for (i = size; i < newSize; i++) {
+	newTable[i] = NULL;
+	newNext[i] = (i + 1 < newSize) ? i + 1 : freeHead;
+    }
+    freeHead = size;
+    delete [] table;
+    delete [] nextFree;
+    table = newTable;
+    nextFree = newNext;
+    size = newSize;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Add
+// 	Give a thread an unused ID, growing the table if every ID is 
+//	taken.
+//
+// Returns:
+//	The thread's new ID.
+//
+//	"thread" is the thread to enter in the table.
+//----------------------------------------------------------------------
+
+int
+ThreadTable::Add(Thread *thread)
+{
+    int tid;
+
+    if (freeHead == -1)
+	Grow();
+    tid = freeHead;
+    freeHead = nextFree[tid];
+    table[tid] = thread;
+    count++;
+    return tid;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Remove
+// 	Free a thread ID, so it can be handed out again.
+//
+//	"tid" is the ID to free; it must be in use.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Remove(int tid)
+{
+    ASSERT(tid >= 0 && tid < size && table[tid] != NULL);
+    table[tid] = NULL;
+    nextFree[tid] = freeHead;
+    freeHead = tid;
+    count--;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Mapcar
+// 	Apply a function to every thread in the table, in order of ID.
+//
+//	"func" is the procedure to apply to each thread.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Mapcar(VoidFunctionPtr func)
+{
+    for (int i = 0; i < size; i++)
+	if (table[i] != NULL)
+	    (*func)((int)table[i]);
+}
@@ -0,0 +1,53 @@
+// threadtable.h 
+//	Data structures to keep track of every thread in the system,
+//	indexed by thread ID.
+//
+//	The table grows (doubling) whenever it runs out of IDs, so there
+//	is no fixed limit on the number of threads.  Free IDs are kept on
+//	a free list threaded through the unused slots, so allocating and
+//	freeing an ID, and looking up a thread by ID, are all constant 
+//	time (allocation is amortized, because of the occasional growth).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADTABLE_H
+#define THREADTABLE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Thread;
+
+#define InitialThreadTableSize	128	// IDs available before the table
+					// first has to grow
+
+class ThreadTable {
+  public:
+    ThreadTable(int initialSize);	// initialize, with every ID free
+    ~ThreadTable();			// de-allocate the table
+
+    int Add(Thread *thread);		// give "thread" an unused ID, 
+					// and return the ID
+    void Remove(int tid);		// free the ID for re-use
+    Thread *Get(int tid)		// thread with this ID, or NULL
+	{ return (tid >= 0 && tid < size) ? table[tid] : NULL; }
+
+    int NumThreads() { return count; }	// threads currently in the table
+    int Size() { return size; }		// IDs run from 0 to Size() - 1
+    void Mapcar(VoidFunctionPtr func);	// apply "func" to every thread,
+					// in order of ID
+
+  private:
+    Thread **table;			// thread owning each ID, or NULL
+    int *nextFree;			// for a free ID, the next free ID
+					// (-1 at the end of the list)
+    int freeHead;			// first free ID, -1 if none
+    int size;				// number of slots in the table
+    int count;				// number of IDs in use
+
+    void Grow();			// double the size of the table
+};
+
+#endif // THREADTABLE_H
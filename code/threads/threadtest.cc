@@ -12,6 +12,8 @@
 #include "copyright.h"
 #include "system.h"
 #include "synch.h"
+#include "synchlist.h"
+#include "ringqueue.h"
 // testnum is set in main.cc
 int testnum = 1;
 
@@ -88,29 +90,27 @@ ThreadTest1()
 // TS()
 //  print information about all threads in system.
 //----------------------------------------------------------------------
-void
-TS()
+static void
+PrintThread(int arg)
 {
-    for(int i=0;i<128;i++)
+    Thread *t=(Thread *)arg;
+    printf("***thread ID %d,   name %s,",t->getTid(),t->getName());
+    switch(t->getStatus())
     {
-        if(threads[i]!=NULL)
-        {
-            printf("***thread ID %d,   name %s,",threads[i]->getTid()
-                    ,threads[i]->getName()
-                    );
-            switch(threads[i]->getStatus())
-            {
-                case JUST_CREATED:printf("   status just_created\n");
-                                  break;
-                case RUNNING:printf("   status running\n");
-                             break;
-                case READY:printf("   status ready\n");
-                           break;
-                default:printf("   status blocked\n");
-            }
-        }
+        case JUST_CREATED:printf("   status just_created\n");
+                          break;
+        case RUNNING:printf("   status running\n");
+                     break;
+        case READY:printf("   status ready\n");
+                   break;
+        default:printf("   status blocked\n");
     }
 }
+void
+TS()
+{
+    threadTable->Mapcar(PrintThread);
+}
 //----------------------------------------------------------------------
 // PrioTest
 // fork 3 threads with different priority to see if preemption happenes
@@ -254,8 +254,9 @@ void producer(int number)
         printf("producer %d produce item %d\n",number,*tem);
         full->Signal(mutex);
         mutex->Release();
-        im->Release();
+        im->Acquire();
     }
+    im->Release();
 }
 void consumer(int number)
 {
@@ -310,6 +311,574 @@ void RWtest()
     
 }
 //----------------------------------------------------------------------
+// MLFQTest
+// run with "-sched mlfq": a CPU-bound thread keeps using up its time
+// slice and sinks, an interactive one yields early and stays on top.
+//----------------------------------------------------------------------
+void
+CPUBound(int time)
+{
+    for(int num=0;num<time;num+=10)
+    {
+        currentThread->advanceTime();
+        if(num%100==0)
+            printf("*** %s at level %d, total time %d\n",
+                    currentThread->getName(),currentThread->getPrio(),
+                    currentThread->getTotaltime());
+    }
+}
+void
+Interactive(int loops)
+{
+    for(int num=0;num<loops;num++)
+    {
+        printf("*** %s at level %d\n",
+                currentThread->getName(),currentThread->getPrio());
+        currentThread->Yield();
+    }
+}
+void
+MLFQTest()
+{
+    Thread *t1=Thread::cap_Thread("cpu-bound",0);
+    Thread *t2=Thread::cap_Thread("interactive",0);
+    t1->Fork(CPUBound,1000);
+    t2->Fork(Interactive,10);
+}
+//----------------------------------------------------------------------
+// CFSTest
+// run with "-sched cfs": three CPU-bound threads of different priority
+// share the CPU for 3000 ticks, in proportion to their weights.
+//----------------------------------------------------------------------
+void
+ShareThread(int until)
+{
+    while(stats->totalTicks<until)
+        currentThread->advanceTime();
+    printf("*** %s with priority %d ran %d ticks, vruntime %lld\n",
+            currentThread->getName(),currentThread->getPrio(),
+            currentThread->getTotaltime(),currentThread->getVruntime());
+}
+void
+CFSTest()
+{
+    Thread *t1=Thread::cap_Thread("high",0);
+    Thread *t2=Thread::cap_Thread("middle",8);
+    Thread *t3=Thread::cap_Thread("low",15);
+    t1->Fork(ShareThread,3000);
+    t2->Fork(ShareThread,3000);
+    t3->Fork(ShareThread,3000);
+}
+//----------------------------------------------------------------------
+// ShareTest
+// run with "-sched stride" or "-sched lottery": three CPU-bound threads
+// holding 100, 200 and 300 tickets share the CPU for 3000 ticks.
+//----------------------------------------------------------------------
+void
+ShareTest()
+{
+    Thread *t1=Thread::cap_Thread("tickets-100");
+    Thread *t2=Thread::cap_Thread("tickets-200");
+    Thread *t3=Thread::cap_Thread("tickets-300");
+    t1->setTickets(100);
+    t2->setTickets(200);
+    t3->setTickets(300);
+    t1->Fork(ShareThread,3000);
+    t2->Fork(ShareThread,3000);
+    t3->Fork(ShareThread,3000);
+}
+//----------------------------------------------------------------------
+// ManyThreadsTest
+// keep 1000 threads alive at once, well past the initial size of the
+// thread table, then let them all finish and check that their IDs
+// are handed out again instead of growing the table further.
+//----------------------------------------------------------------------
+void
+Quiet(int which)
+{
+}
+void
+ManyThreadsTest()
+{
+    int maxnum=1000;
+    IntStatus oldLevel=interrupt->SetLevel(IntOff);  // no time slicing,
+    for(int i=0;i<maxnum;i++)                        // so none finish yet
+    {
+        Thread *t=Thread::cap_Thread("many");
+        t->Fork(Quiet,i);
+    }
+    printf("%d threads, table size %d\n",
+            threadTable->NumThreads(),threadTable->Size());
+    (void) interrupt->SetLevel(oldLevel);
+    currentThread->Yield();             // let them all run and finish
+    Thread *t=Thread::cap_Thread("again");
+    printf("%d threads, table size %d, new thread gets ID %d\n",
+            threadTable->NumThreads(),threadTable->Size(),t->getTid());
+    delete t;
+}
+//----------------------------------------------------------------------
+// SmallStackTest
+// keep 2000 threads alive at once, each on a stack of the smallest size
+// Fork accepts rather than the default.
+//----------------------------------------------------------------------
+void
+SmallStackTest()
+{
+    int maxnum=2000;
+    IntStatus oldLevel=interrupt->SetLevel(IntOff);
+    for(int i=0;i<maxnum;i++)
+    {
+        Thread *t=Thread::cap_Thread("small");
+        t->Fork(Quiet,i,MinStackSize);
+    }
+    printf("%d threads on %d-word stacks\n",
+            threadTable->NumThreads()-1,MinStackSize);
+    (void) interrupt->SetLevel(oldLevel);
+}
+//----------------------------------------------------------------------
+// OverflowTest
+// recurse without bound on a small stack; Nachos should stop with a
+// message naming the thread as soon as it runs into the guard page.
+//----------------------------------------------------------------------
+void
+Recurse(int depth)
+{
+    char frame[256];
+    frame[0]=depth;
+    if(depth>=0)                        // always; but the compiler
+        Recurse(depth+1);               // can't tell it never returns
+    printf("%d\n",frame[0]);           // never reached
+}
+void
+OverflowTest()
+{
+    Thread *t=Thread::cap_Thread("deep");
+    t->Fork(Recurse,0,MinStackSize);
+}
+//----------------------------------------------------------------------
+// SmpTest
+// run with "-cpus N": eight threads each do 500 ticks of work.  With
+// more CPUs they should finish sooner, spread over all the CPUs.
+//----------------------------------------------------------------------
+void
+Worker(int work)
+{
+    for(int num=0;num<work;num+=SystemTick)
+        currentThread->advanceTime();
+    printf("*** %s finished on CPU %d at time %d\n",
+            currentThread->getName(),currentCpu->id,stats->totalTicks);
+}
+void
+SmpTest()
+{
+    static char *names[]={"worker0","worker1","worker2","worker3",
+                          "worker4","worker5","worker6","worker7"};
+    for(int i=0;i<8;i++)
+    {
+        Thread *t=Thread::cap_Thread(names[i]);
+        t->Fork(Worker,500);
+    }
+}
+//----------------------------------------------------------------------
+// JoinTest
+// fork joinable threads that each add up part of 1..400 and exit with
+// their sum, and join them in order for the total, whether or not they
+// have finished yet.  A detached thread is deleted as soon as it
+// finishes, without being joined.
+//----------------------------------------------------------------------
+void
+PartialSum(int part)
+{
+    int sum=0;
+    for(int i=part*100+1;i<=(part+1)*100;i++)
+    {
+        sum+=i;
+        if(i%25==0)
+            currentThread->advanceTime();
+    }
+    printf("*** %s summed part %d at time %d\n",
+            currentThread->getName(),part,stats->totalTicks);
+    currentThread->Exit(sum);
+}
+void
+JoinTest()
+{
+    static char *names[]={"part0","part1","part2","part3"};
+    Thread *parts[4];
+    int total=0;
+    for(int i=0;i<4;i++)
+    {
+        parts[i]=Thread::cap_Thread(names[i],15,TRUE);
+        parts[i]->Fork(PartialSum,i);
+    }
+    Thread *t=Thread::cap_Thread("detached",15,TRUE);
+    t->Fork(Quiet,0);
+    t->Detach();
+    for(int i=0;i<4;i++)
+    {
+        int sum=parts[i]->Join();
+        printf("*** joined %s: sum %d at time %d\n",
+                names[i],sum,stats->totalTicks);
+        total+=sum;
+    }
+    printf("total %d (expected %d), %d threads left\n",
+            total,400*401/2,threadTable->NumThreads());
+}
+//----------------------------------------------------------------------
+// AlarmTest
+// a few threads sleep for very different lengths of time, up to 100000
+// ticks, and 1000 more sleep for pseudo-random lengths, all at once.
+// None may wake before its time is up, and since sleeping threads
+// use no CPU, the machine should be idle most of the time.
+//----------------------------------------------------------------------
+void
+Napper(int howLong)
+{
+    int start=stats->totalTicks;
+    alarmClock->Pause(howLong);
+    currentThread->Exit(stats->totalTicks-(start+howLong));
+}
+void
+AlarmTest()
+{
+    static char *names[]={"nap-100000","nap-10000","nap-1000"};
+    static int lengths[]={100000,10000,1000};
+    Thread *t[1003];
+    int early=0,latest=0;
+    for(int i=0;i<3;i++)
+    {
+        t[i]=Thread::cap_Thread(names[i],15,TRUE);
+        t[i]->Fork(Napper,lengths[i]);
+    }
+    for(int i=3;i<1003;i++)
+    {
+        t[i]=Thread::cap_Thread("napper",15,TRUE);
+        t[i]->Fork(Napper,1+Random()%50000,MinStackSize);
+    }
+    for(int i=0;i<1003;i++)
+    {
+        int late=t[i]->Join();
+        if(i<3)
+            printf("*** joined %s at time %d, %d ticks late\n",
+                    names[i],stats->totalTicks,late);
+        if(late<0)
+            early++;
+        latest=max(latest,late);
+    }
+    printf("%d sleepers woke early, the latest %d ticks late\n",
+            early,latest);
+}
+//----------------------------------------------------------------------
+// InheritTest
+// run with "-sched prio": "low" (priority 12) takes lock A, "middle" (6)
+// takes lock B and waits for A, and "high" (1) waits for B.  Both 
+// holders should run at priority 1 until they let go, so that "busy",
+// a CPU-bound thread of priority 3, can't keep high from its lock.
+//----------------------------------------------------------------------
+Lock *lockA,*lockB;
+void
+Busy(int which)
+{
+    for(int num=0;num<10;num++)
+        currentThread->advanceTime();
+    printf("*** busy finished at time %d\n",stats->totalTicks);
+}
+void
+High(int which)
+{
+    printf("*** high waits for lock B\n");
+    lockB->Acquire();
+    printf("*** high got lock B at time %d\n",stats->totalTicks);
+    lockB->Release();
+}
+void
+Middle(int which)
+{
+    lockB->Acquire();
+    printf("*** middle holds lock B, waits for lock A\n");
+    lockA->Acquire();
+    printf("*** middle got lock A, at priority %d\n",
+            currentThread->getPrio());
+    lockA->Release();
+    printf("*** middle released lock A, at priority %d\n",
+            currentThread->getPrio());
+    lockB->Release();
+    printf("*** middle released lock B, at priority %d\n",
+            currentThread->getPrio());
+}
+void
+Low(int which)
+{
+    lockA->Acquire();
+    Thread::cap_Thread("middle",6)->Fork(Middle,0);
+    printf("*** low holds lock A, at priority %d\n",
+            currentThread->getPrio());
+    Thread::cap_Thread("high",1)->Fork(High,0);
+    printf("*** low holds lock A, at priority %d\n",
+            currentThread->getPrio());
+    Thread::cap_Thread("busy",3)->Fork(Busy,0);
+    for(int num=0;num<10;num++)
+        currentThread->advanceTime();
+    lockA->Release();
+    printf("*** low released lock A, at priority %d\n",
+            currentThread->getPrio());
+}
+void
+InheritTest()
+{
+    lockA=new Lock("lock A");
+    lockB=new Lock("lock B");
+    Thread::cap_Thread("low",12)->Fork(Low,0);
+}
+//----------------------------------------------------------------------
+// RWPolicyTest
+// six readers keep a readers/writer lock busy, overlapping one another,
+// while two writers try to get in; once for each policy.  Preferring 
+// readers, the writers should wait until the readers are nearly done;
+// preferring writers, the readers wait instead; phase-fair, neither 
+// side should wait long.
+//----------------------------------------------------------------------
+RWLock *policyLock;
+int readerWait,writerWait;      // longest wait of each kind
+void
+PolicyReader(int which)
+{
+    for(int num=0;num<5;num++)
+    {
+        int start=stats->totalTicks;
+        policyLock->RAcquire();
+        readerWait=max(readerWait,stats->totalTicks-start);
+        for(int i=0;i<3;i++)
+            currentThread->advanceTime();
+        policyLock->RRelease();
+        currentThread->advanceTime();
+    }
+}
+void
+PolicyWriter(int which)
+{
+    for(int num=0;num<3;num++)
+    {
+        int start=stats->totalTicks;
+        policyLock->WAcquire();
+        writerWait=max(writerWait,stats->totalTicks-start);
+        for(int i=0;i<3;i++)
+            currentThread->advanceTime();
+        policyLock->WRelease();
+        currentThread->advanceTime();
+    }
+}
+void
+RWPolicyTest()
+{
+    static char *names[]={"prefer readers","prefer writers","phase fair"};
+    Thread *t[8];
+    for(int p=0;p<3;p++)
+    {
+        int start=stats->totalTicks;
+        policyLock=new RWLock("policy",(RWPolicy)p);
+        readerWait=writerWait=0;
+        for(int i=0;i<8;i++)
+        {
+            t[i]=Thread::cap_Thread((i<6)?(char *)"reader":(char *)"writer",
+                    15,TRUE);
+            t[i]->Fork((i<6)?PolicyReader:PolicyWriter,i);
+        }
+        for(int i=0;i<8;i++)
+            t[i]->Join();
+        printf("*** %s: readers waited at most %d ticks, writers %d, "
+                "done in %d ticks\n",names[p],readerWait,writerWait,
+                stats->totalTicks-start);
+        delete policyLock;
+    }
+}
+//----------------------------------------------------------------------
+// BroadcastTest
+// twenty threads wait at a gate; a Broadcast opens it while the lock
+// is held for a few more ticks, and each thread then does a little 
+// work under the lock.  Since Broadcast moves the waiters onto the 
+// lock's queue, each one should be switched to once, when it can have
+// the lock, instead of also waking up early only to find it busy.
+//----------------------------------------------------------------------
+Lock *gateLock;
+Condition *gate;
+bool gateOpen=FALSE;
+void
+GateWaiter(int which)
+{
+    gateLock->Acquire();
+    while(!gateOpen)
+        gate->Wait(gateLock);
+    currentThread->advanceTime();
+    gateLock->Release();
+}
+void
+BroadcastTest()
+{
+    Thread *t[20];
+    gateLock=new Lock("gate lock");
+    gate=new Condition("gate");
+    for(int i=0;i<20;i++)
+    {
+        t[i]=Thread::cap_Thread("waiter",15,TRUE);
+        t[i]->Fork(GateWaiter,i);
+    }
+    currentThread->Yield();         // let them all get to the gate
+    int before=stats->numContextSwitches;
+    gateLock->Acquire();
+    gateOpen=TRUE;
+    gate->Broadcast(gateLock);
+    for(int i=0;i<TimeSlice/SystemTick;i++)
+        currentThread->advanceTime();
+    gateLock->Release();
+    for(int i=0;i<20;i++)
+        t[i]->Join();
+    printf("*** 20 waiters through the gate in %d context switches\n",
+            stats->numContextSwitches-before);
+}
+//----------------------------------------------------------------------
+// PoolTest
+// a pool of ten buffers, counted by a semaphore.  While main holds six,
+// "big" asks for eight; the smaller requests made after it have to 
+// wait their turn behind it, even though there would be enough for 
+// them.  Each V(n) then wakes as many waiters as it can satisfy.
+//----------------------------------------------------------------------
+Semaphore *pool;
+void
+PoolUser(int n)
+{
+    pool->P(n);
+    printf("*** %s got %d buffers at time %d\n",
+            currentThread->getName(),n,stats->totalTicks);
+    for(int i=0;i<3;i++)
+        currentThread->advanceTime();
+    printf("*** %s gives back %d buffers\n",currentThread->getName(),n);
+    pool->V(n);
+}
+void
+PoolTest()
+{
+    static char *names[]={"big","small1","small2","small3"};
+    static int wants[]={8,2,2,1};
+    Thread *t[4];
+    pool=new Semaphore("pool",10);
+    pool->P(6);
+    for(int i=0;i<4;i++)
+    {
+        t[i]=Thread::cap_Thread(names[i],15,TRUE);
+        t[i]->Fork(PoolUser,wants[i]);
+    }
+    currentThread->Yield();         // let them all ask
+    printf("*** main gives back 6 buffers\n");
+    pool->V(6);
+    for(int i=0;i<4;i++)
+        t[i]->Join();
+    pool->P(10);
+    printf("*** all 10 buffers back in the pool\n");
+}
+//----------------------------------------------------------------------
+// QueueBench
+// two producers each pass 1000 messages to two consumers, first
+// through a SynchList and then through a 16-slot RingQueue, doing a
+// tick of work per message.  Report the throughput of each, in 
+// messages per simulated second, taking a tick to be a microsecond.
+//----------------------------------------------------------------------
+#define BenchMessages 1000
+SynchList *benchList;
+RingQueue *benchRing;
+void
+BenchProducer(int ring)
+{
+    for(int i=1;i<=BenchMessages;i++)
+    {
+        currentThread->advanceTime();
+        if(ring)
+            benchRing->Append((void *)i);
+        else
+            benchList->Append((void *)i);
+    }
+}
+void
+BenchConsumer(int ring)
+{
+    for(int i=0;i<BenchMessages;i++)
+    {
+        if(ring)
+            benchRing->Remove();
+        else
+            benchList->Remove();
+    }
+}
+void
+QueueBench()
+{
+    static char *names[]={"SynchList","RingQueue"};
+    Thread *t[4];
+    benchList=new SynchList;
+    benchRing=new RingQueue("bench",16);
+    for(int ring=0;ring<2;ring++)
+    {
+        int start=stats->totalTicks;
+        int switches=stats->numContextSwitches;
+        for(int i=0;i<4;i++)
+        {
+            t[i]=Thread::cap_Thread((i<2)?(char *)"producer":
+                    (char *)"consumer",15,TRUE);
+            t[i]->Fork((i<2)?BenchProducer:BenchConsumer,ring);
+        }
+        for(int i=0;i<4;i++)
+            t[i]->Join();
+        int ticks=stats->totalTicks-start;
+        printf("*** %s: %d messages in %d ticks, %d context switches, "
+                "%d messages per simulated second\n",names[ring],
+                2*BenchMessages,ticks,stats->numContextSwitches-switches,
+                (int)(2*BenchMessages*1000000.0/ticks));
+    }
+    delete benchList;
+    delete benchRing;
+}
+//----------------------------------------------------------------------
+// DeadlockTest
+// three philosophers at a round table, each picking up the fork on 
+// its left, then the one on its right.  Two of the forks are locks, 
+// and one is a semaphore used as a mutex.  They all get their left 
+// fork before anyone tries for a right one, so they deadlock; run 
+// with -deadlock to have the cycle reported as it closes.
+//----------------------------------------------------------------------
+Lock *forkLock[2];
+Semaphore *forkSema;
+int seated;
+void
+PickUp(int fork)
+{
+    printf("*** %s picks up fork %d\n",currentThread->getName(),fork);
+    if(fork<2)
+        forkLock[fork]->Acquire();
+    else
+        forkSema->P();
+}
+void
+Philosopher(int which)
+{
+    PickUp(which);
+    seated++;
+    while(seated<3)
+        currentThread->Yield();     // wait for the others to get theirs
+    PickUp((which+1)%3);
+    printf("*** %s eats\n",currentThread->getName());
+}
+void
+DeadlockTest()
+{
+    static char *names[]={"plato","kant","hume"};
+    forkLock[0]=new Lock("fork0");
+    forkLock[1]=new Lock("fork1");
+    forkSema=new Semaphore("fork2",1);
+    seated=0;
+    for(int i=0;i<3;i++)
+        Thread::cap_Thread(names[i])->Fork(Philosopher,i);
+}
+//----------------------------------------------------------------------
 // ThreadTest
 // 	Invoke a test routine.
 //----------------------------------------------------------------------
@@ -318,6 +887,51 @@ void
 ThreadTest()
 {
     switch (testnum){
+    case 22:
+        DeadlockTest();
+        break;
+    case 21:
+        QueueBench();
+        break;
+    case 20:
+        PoolTest();
+        break;
+    case 19:
+        BroadcastTest();
+        break;
+    case 18:
+        RWPolicyTest();
+        break;
+    case 17:
+        InheritTest();
+        break;
+    case 16:
+        AlarmTest();
+        break;
+    case 15:
+        JoinTest();
+        break;
+    case 14:
+        SmpTest();
+        break;
+    case 13:
+        OverflowTest();
+        break;
+    case 12:
+        SmallStackTest();
+        break;
+    case 11:
+        ManyThreadsTest();
+        break;
+    case 10:
+        ShareTest();
+        break;
+    case 9:
+        CFSTest();
+        break;
+    case 8:
+        MLFQTest();
+        break;
     case 7:
         RWtest();
         break;
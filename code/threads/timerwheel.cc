@@ -0,0 +1,122 @@
+// timerwheel.cc
+//	Routines to manage a hierarchical timer wheel.
+//
+//	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "timerwheel.h"
+
+// the slot that period "t" falls in, on level "level"
+#define SlotOf(t, level)	(((t) >> (WheelBits * (level))) & (WheelSlots - 1))
+
+//----------------------------------------------------------------------
+// TimerWheel::TimerWheel
+//	Initialize a timer wheel, at period 0, with every slot empty.
+//----------------------------------------------------------------------
+
+TimerWheel::TimerWheel()
+{
+    for (int level = 0; level < WheelLevels; level++)
+	for (int i = 0; i < WheelSlots; i++)
+	    slots[level][i] = NULL;
+    now = 0;
+    numPending = 0;
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::Insert
+//	Add a timeout to the wheel.  A timeout too far in the future to
+//	fit on the wheel is cut back to the furthest period that does;
+//	one in the past expires in the next period.
+//
+//	"node" is the timeout; it must not already be on the wheel.
+//	"expires" is the period in which it should expire.
+//----------------------------------------------------------------------
+
+void
+TimerWheel::Insert(WheelNode *node, int expires)
+{
+    if (expires <= now)
+	expires = now + 1;
+    else if (expires - now >= WheelSpan)
+	expires = now + WheelSpan - 1;
+    node->expires = expires;
+    Place(node);
+    numPending++;
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::Place
+//	Put a timeout in the slot for its period, on the lowest level
+//	whose slots reach that far ahead.
+//----------------------------------------------------------------------
+
+void
+TimerWheel::Place(WheelNode *node)
+{
+    int delta = node->expires - now;
+    int level = 0;
+
+    while (level < WheelLevels - 1
+	    && delta >= (1 << (WheelBits * (level + 1))))
+	level++;
+    WheelNode **slot = &slots[level][SlotOf(node->expires, level)];
+
+    node->next = *slot;
+    *slot = node;
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::Cascade
+//	Empty the slot of "level" for the current period, and put each of
+//	its timeouts back on a lower level, now that they are closer.
+//----------------------------------------------------------------------
+
+void
+TimerWheel::Cascade(int level)
+{
+    WheelNode **slot = &slots[level][SlotOf(now, level)];
+    WheelNode *node = *slot;
+
+    *slot = NULL;
+    while (node != NULL) {
+	WheelNode *next = node->next;
+
+	Place(node);
+	node = next;
+    }
+}
+
+//----------------------------------------------------------------------
+// TimerWheel::Advance
+//	Move on to the next period.  If that wraps around the slots of a
+//	level, first bring down the timeouts of the next slot up.
+//
+// Returns:
+//	The timeouts that expire in the new period, linked through their
+//	"next" fields, or NULL if there are none.  They are no longer on
+//	the wheel.
+//----------------------------------------------------------------------
+
+WheelNode *
+TimerWheel::Advance()
+{
+    WheelNode **slot;
+    WheelNode *expired;
+
+    now++;
+    for (int level = 1; level < WheelLevels
+	    && SlotOf(now, level - 1) == 0; level++)
+	Cascade(level);
+
+    slot = &slots[0][SlotOf(now, 0)];
+    expired = *slot;
+    *slot = NULL;
+    for (WheelNode *node = expired; node != NULL; node = node->next)
+	numPending--;
+    return expired;
+}
@@ -0,0 +1,76 @@
+// timerwheel.h
+//	Data structures for a hierarchical timer wheel -- a set of
+//	timeouts, kept so that adding one and expiring one both take
+//	constant time, no matter how many are pending.
+//
+//	Time is counted in "periods" (for the Alarm, one period is one
+//	timer interrupt).  The wheel has WheelLevels levels of WheelSlots
+//	slots each.  Level 0 has a slot for each of the next WheelSlots
+//	periods; each slot of level 1 covers WheelSlots periods, each
+//	slot of level 2 covers WheelSlots times that, and so on.  A
+//	timeout goes in the lowest level that reaches far enough.  Every
+//	time the level 0 index wraps around, the next slot of level 1 is
+//	emptied and its timeouts are spread over level 0 (and likewise
+//	further up), so that each timeout is moved at most once per
+//	level.
+//
+//	Like RBTree, the wheel does not allocate anything: the caller
+//	supplies a WheelNode for each timeout.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include "copyright.h"
+#include "utility.h"
+
+#define WheelBits	6
+#define WheelSlots	(1 << WheelBits)	// slots per level
+#define WheelLevels	4			// so timeouts up to 2^24
+						// periods ahead can be kept
+#define WheelSpan	(1 << (WheelBits * WheelLevels))
+
+// The following class defines one pending timeout.  Users should only
+// set "item"; the rest belongs to the wheel.
+
+class WheelNode {
+  public:
+    WheelNode() { item = NULL; expires = 0; next = NULL; }
+
+    void *item;			// what to hand back when it expires
+    int expires;		// period in which it expires
+    WheelNode *next;		// next timeout in the same slot
+};
+
+// The following class defines a hierarchical timer wheel.
+
+class TimerWheel {
+  public:
+    TimerWheel();		// initialize the wheel, at period 0, with
+				// no timeouts
+
+    void Insert(WheelNode *node, int expires);	// expire "node" in
+				// period "expires"; if that has already
+				// come, in the next period
+    WheelNode *Advance();	// move on to the next period, and return
+				// the list of nodes that expire in it,
+				// linked through "next"
+    int Now() { return now; }	// the current period
+    bool IsEmpty() { return (numPending == 0); }
+    int NumPending() { return numPending; }
+
+  private:
+    WheelNode *slots[WheelLevels][WheelSlots];	// the timeouts, in
+				// unordered lists
+    int now;			// current period
+    int numPending;		// number of timeouts on the wheel
+
+    void Place(WheelNode *node);	// put node in the right slot
+    void Cascade(int level);	// spread the current slot of "level" over
+				// the levels below
+};
+
+#endif // TIMERWHEEL_H
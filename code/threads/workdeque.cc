@@ -0,0 +1,104 @@
+// workdeque.cc 
+//	Routines to manage a work-stealing deque of threads.  Item i 
+//	lives at items[i & mask]; the threads on the deque are those
+//	from "top" up to (but not including) "bottom".
+//
+//	NOTE: Mutual exclusion must be provided by the caller, by 
+//	disabling interrupts.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "workdeque.h"
+
+//----------------------------------------------------------------------
+// WorkDeque::WorkDeque
+// 	Initialize a deque, empty to start with.
+//----------------------------------------------------------------------
+
+WorkDeque::WorkDeque()
+{
+    items = new Thread *[InitialDequeSize];
+    mask = InitialDequeSize - 1;
+    top = bottom = 0;
+}
+
+//----------------------------------------------------------------------
+// WorkDeque::~WorkDeque
+// 	De-allocate a deque.  The threads on it are not touched.
+//----------------------------------------------------------------------
+
+WorkDeque::~WorkDeque()
+{
+    delete [] items;
+}
+
+//----------------------------------------------------------------------
+// WorkDeque::Grow
+// 	Double the size of the circular array, copying the threads on 
+//	the deque to the same indices in the new array.
+//----------------------------------------------------------------------
+
+void
+WorkDeque::Grow()
+{
+    int newMask = mask * 2 + 1;
+    Thread **newItems = new Thread *[newMask + 1];
+
+    for (int i = top; i < bottom; i++)
+	newItems[i & newMask] = items[i & mask];
+    delete [] items;
+    items = newItems;
+    mask = newMask;
+}
+
+//----------------------------------------------------------------------
+// WorkDeque::PushBottom
+// 	Put a thread on the bottom (the owner's end) of the deque.
+//----------------------------------------------------------------------
+
+void
+WorkDeque::PushBottom(Thread *thread)
+{
+    if (bottom == top)			// empty: start over at 0, so
+	top = bottom = 0;		// the counters never overflow
+    else if (bottom - top > mask)	// full
+	Grow();
+    items[bottom & mask] = thread;
+    bottom++;
+}
+
+//----------------------------------------------------------------------
+// WorkDeque::PopBottom
+// 	Take the newest thread off the bottom of the deque.  Return NULL 
+//	if the deque is empty.
+//----------------------------------------------------------------------
+
+Thread *
+WorkDeque::PopBottom()
+{
+    if (bottom == top)
+	return NULL;
+    bottom--;
+    return items[bottom & mask];
+}
+
+//----------------------------------------------------------------------
+// WorkDeque::Steal
+// 	Take the oldest thread off the top of the deque.  Return NULL 
+//	if the deque is empty.
+//----------------------------------------------------------------------
+
+Thread *
+WorkDeque::Steal()
+{
+    Thread *thread;
+
+    if (bottom == top)
+	return NULL;
+    thread = items[top & mask];
+    top++;
+    return thread;
+}
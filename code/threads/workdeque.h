@@ -0,0 +1,53 @@
+// workdeque.h 
+//	Data structures for a work-stealing deque of threads, after 
+//	Chase and Lev ("Dynamic Circular Work-Stealing Deque", SPAA 2005).
+//
+//	The deque belongs to one CPU.  The owner pushes and pops threads
+//	at the bottom, so it gets back the thread it queued most recently
+//	-- the one most likely to still have its data in the CPU's cache.
+//	Other CPUs steal from the top, taking the oldest thread, which is
+//	least likely to be cache-hot on the owner.
+//
+//	The items live in a circular array indexed by two counters that 
+//	only ever increase; the array doubles when it fills up.  The real
+//	algorithm needs a compare-and-swap to settle a race between the
+//	owner and a thief for the last item.  Our simulated CPUs only 
+//	change turns when interrupts are re-enabled, and the deque is 
+//	only used with interrupts off, so plain loads and stores suffice.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef WORKDEQUE_H
+#define WORKDEQUE_H
+
+#include "copyright.h"
+#include "utility.h"
+
+class Thread;
+
+#define InitialDequeSize	32	// must be a power of two
+
+class WorkDeque {
+  public:
+    WorkDeque();			// initialize an empty deque
+    ~WorkDeque();			// de-allocate the deque
+
+    void PushBottom(Thread *thread);	// owner: add a thread
+    Thread *PopBottom();		// owner: take the newest thread
+    Thread *Steal();			// thief: take the oldest thread
+
+    bool IsEmpty() { return (bottom == top); }
+    int Size() { return (bottom - top); }
+
+  private:
+    Thread **items;			// circular array of threads
+    int mask;				// array size - 1
+    int top;				// index of the oldest thread
+    int bottom;				// index one past the newest thread
+
+    void Grow();			// double the size of the array
+};
+
+#endif // WORKDEQUE_H
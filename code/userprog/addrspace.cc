@@ -125,6 +125,8 @@ AddrSpace::AddrSpace(OpenFile *executable)
 
 AddrSpace::~AddrSpace()
 {
+   if (loaded == this)		// a new space could be allocated here
+	loaded = NULL;
    delete pageTable;
 }
 
@@ -176,11 +178,28 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//      For now, tell the machine where to find the page table, and
+//	flush the TLB, which holds the old address space's translations.
+//	If the machine already has this address space (we are switching
+//	between threads that share it, or back to the same thread), 
+//	there is nothing to do; the old space is only saved now that
+//	it is being replaced.
 //----------------------------------------------------------------------
 
+AddrSpace *AddrSpace::loaded = NULL;
+
 void AddrSpace::RestoreState() 
 {
+    if (loaded == this)
+	return;
+    if (loaded != NULL)
+	loaded->SaveState();
     machine->pageTable = pageTable;
     machine->pageTableSize = numPages;
+#ifdef USE_TLB
+    for (int i = 0; i < TLBSize; i++)
+	machine->tlb[i].valid = FALSE;
+#endif
+    loaded = this;
+    stats->numSpaceLoads++;
 }
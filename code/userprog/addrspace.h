@@ -32,6 +32,8 @@ class AddrSpace {
     void RestoreState();		// info on a context switch 
 
   private:
+    static AddrSpace *loaded;		// the address space whose 
+					// translations the machine holds
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
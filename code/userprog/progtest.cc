@@ -32,6 +32,8 @@ StartProcess(char *filename)
     }
     space = new AddrSpace(executable);    
     currentThread->space = space;
+    currentThread->RestoreUserState();	// take the machine's registers 
+					// over from the last user thread
 
     delete executable;			// close file
 